@@ -0,0 +1,36 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Boot orchestrator: overlaps the slow, independent startup stages instead
+// of running them as a serial chain. SD card initialization (CMD0/CMD8/
+// ACMD41 plus FAT32 mount, seconds of mostly waiting) runs on core 1 while
+// core 0 brings up the radio and associates; the MQTT-SN handshake then
+// proceeds while the card is still mounting. Battery nodes duty-cycle
+// through full reboots, so every second of boot is a second of radio-on
+// battery burn.
+
+// SD join results
+#define STARTUP_ESDINIT  -1  // Hardware init failed on core 1
+#define STARTUP_ESDMOUNT -2  // FAT32 mount failed on core 1
+#define STARTUP_ETIMEOUT -3  // Background init still running (or never started)
+
+// Record boot t0 and launch SD init + mount on core 1. Call before
+// wifi_init() so the card's command sequence overlaps association.
+void startup_begin(void);
+
+// True while the background SD init is still running on core 1.
+bool startup_sd_busy(void);
+
+// Wait for the background SD init to finish (up to timeout_ms), then free
+// core 1 for other workers (e.g. the block pipeline). Returns 0 when the
+// card is initialized and mounted, otherwise a STARTUP_E* code - callers
+// can fall back to a synchronous init on core 0.
+int startup_sd_join(uint32_t timeout_ms);
+
+// Print a boot timeline marker: "[BOOT] <stage> at <ms> ms".
+void startup_mark(const char *stage);
+
+#endif // STARTUP_H
@@ -8,4 +8,12 @@
 #define MQTTSN_GATEWAY_IP "YOUR_LAPTOP_IP"  // Your laptop's IP address (found using `ipconfig /all` for windows / `ip a` for linux)
 #define MQTTSN_GATEWAY_PORT 1884
 
+// Optional standby gateways for automatic failover (see mqttsn_gateway.h).
+// Uncomment and point at a second/third gateway host; the node probes all
+// of them with PINGREQ and publishes to the lowest-latency healthy one.
+// #define MQTTSN_GATEWAY2_IP "SECOND_GATEWAY_IP"
+// #define MQTTSN_GATEWAY2_PORT 1884
+// #define MQTTSN_GATEWAY3_IP "THIRD_GATEWAY_IP"
+// #define MQTTSN_GATEWAY3_PORT 1884
+
 #endif // WIFI_DRIVER_H
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Statically reserved arena for transfer-path buffers. Allocation is an
+// O(1) pointer bump and the whole arena is reclaimed with one reset at
+// transfer boundaries, so the long-running-node fragmentation failure
+// mode of malloc/free simply cannot happen. The region is carved out at
+// link time - if it fits in the image, it fits at runtime.
+#define ARENA_SIZE 60000   // Matches the old 60KB transfer buffer budget
+
+// Hand out an aligned region, or NULL when the arena is exhausted
+void *arena_alloc(size_t size);
+
+// Reclaim everything (per-transfer semantics: call between transfers,
+// never while a region handed out for the current transfer is in use)
+void arena_reset(void);
+
+// Telemetry: current occupancy and lifetime high-water mark, in bytes
+size_t arena_used(void);
+size_t arena_high_water(void);
+
+#endif // ARENA_H
@@ -0,0 +1,27 @@
+// block_pipeline.h - Dual-core block transfer pipeline
+// Core 0 owns the radio/lwIP/MQTT-SN receive path; core 1 owns SD card I/O
+// and chunk reassembly. The two are connected by a lock-free SPSC queue so a
+// blocking SD write can never stall packet reception.
+
+#ifndef BLOCK_PIPELINE_H
+#define BLOCK_PIPELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Launch the core 1 worker. Call once, after the SD card is mounted.
+int block_pipeline_start(void);
+
+// True once the core 1 worker is running
+bool block_pipeline_active(void);
+
+// Hand a raw chunk packet (header + data) to core 1. Called from the core 0
+// receive path; never blocks. Returns 0 on success, -1 if the queue is full
+// (the chunk is dropped and the NACK path recovers it).
+int block_pipeline_submit_chunk(const uint8_t *data, size_t len);
+
+// Chunks dropped because the queue was full
+uint32_t block_pipeline_dropped(void);
+
+#endif // BLOCK_PIPELINE_H
@@ -4,19 +4,63 @@
 #include "pico/stdlib.h"
 
 // Block transfer constants
-#define BLOCK_CHUNK_SIZE 128        // Size of each chunk (adjust based on MQTT-SN packet limits)
+#define BLOCK_CHUNK_SIZE 128        // Fallback / minimum chunk size (always passes)
+#define BLOCK_CHUNK_SIZE_MAX 1024   // Largest chunk size the MTU probe may negotiate
 #define BLOCK_MAX_CHUNKS 1000       // Maximum number of chunks per block
+#define BLOCK_BITMAP_WORDS ((BLOCK_MAX_CHUNKS + 31) / 32)  // Chunk bitmap size in uint32 words
 #define BLOCK_BUFFER_SIZE 60000     // 60KB buffer - safe for Pico W's 264KB RAM
 #define MAX_SUPPORTED_FILE_SIZE 58000  // Maximum file size we can handle (58KB)
 
+// Per-chunk header flags
+#define BLOCK_FLAG_COMPRESSED 0x01  // Payload is LZSS-compressed (see lzss.h)
+
 // Block transfer header structure (packed to avoid alignment issues)
 typedef struct __attribute__((packed)) {
     uint16_t block_id;      // Unique block identifier
-    uint16_t part_num;      // Current part number (1-based)
+    uint16_t part_num;      // Current part number (1-based; 0 = control message)
     uint16_t total_parts;   // Total number of parts
-    uint16_t data_len;      // Length of data in this chunk
+    uint16_t data_len;      // Length of data in this chunk (as transmitted)
+    uint8_t flags;          // BLOCK_FLAG_* bits
+    uint8_t chunk_size_64;  // Transfer chunk size / 64 - every chunk self-describes,
+                            // so the receiver can place any chunk that arrives first
+    uint32_t data_crc;      // CRC-32 of the transmitted bytes (DMA sniffer)
 } block_header_t;
 
+// Path-MTU probe control message: part_num == 0, data_len bytes of padding
+// with this as the first payload byte. Sent QoS 1 before a transfer; the
+// largest probe whose PUBACK comes back sets the negotiated chunk size.
+// Receivers ignore it.
+#define BLOCK_PROBE_MAGIC 0xA7
+
+// End-of-transfer control message: part_num == 0, data_len == 0, and
+// data_crc carries the CRC-32 of the whole file. The receiver checks it
+// against the file as written to SD, so SPI/SD corruption is caught too.
+
+// Delta announce control message: part_num == 0 with this payload (plus a
+// reuse bitmap of ((total_parts + 31) / 32) uint32 words, bit N set =
+// chunk N+1 is byte-identical to the base transfer and will not be sent).
+// The receiver splices those chunks from its saved copy of the base file;
+// anything it cannot splice is recovered through the normal SACK path.
+#define BLOCK_DELTA_MAGIC 0xD1
+typedef struct __attribute__((packed)) {
+    uint8_t magic;          // BLOCK_DELTA_MAGIC
+    uint8_t reserved;       // Zero for now
+    uint16_t base_block_id; // Transfer the unchanged chunks come from
+    uint16_t base_total;    // Chunk count of the base file
+} block_delta_header_t;
+
+// Binary SACK (selective-ack) retransmit request: header followed by
+// ((up_to + 31) / 32) uint32 words, bit N set = chunk N+1 is missing.
+// One fixed-layout packet describes any loss pattern, unlike the ASCII
+// range list which overflows with scattered loss.
+#define BLOCK_SACK_MAGIC 0xB5
+typedef struct __attribute__((packed)) {
+    uint8_t magic;          // BLOCK_SACK_MAGIC (first byte; ASCII NACKs start with 'N')
+    uint8_t reserved;       // Zero for now
+    uint16_t block_id;      // Transfer this request applies to
+    uint16_t up_to;         // Bitmap covers chunks 1..up_to
+} block_sack_header_t;
+
 // Block reassembly structure
 typedef struct {
     uint16_t block_id;
@@ -35,6 +79,10 @@ int send_block_transfer(const char *topic, const uint8_t *data, size_t data_len)
 int send_block_transfer_qos(const char *topic, const uint8_t *data, size_t data_len, uint8_t qos);
 int send_image_file(const char *topic, const char *filename);
 int send_image_file_qos(const char *topic, const char *filename, uint8_t qos);
+// Like send_image_file_qos, but chunks identical to the last fully sent
+// file are skipped (the receiver splices them from its saved copy).
+// Falls back to a full send when there is no baseline yet.
+int send_image_file_delta(const char *topic, const char *filename, uint8_t qos);
 void process_block_chunk(const uint8_t *data, size_t len);
 void generate_large_message(char *buffer, size_t size);
 bool block_transfer_is_active(void);
@@ -43,6 +91,7 @@ void block_transfer_print_status(void);
 int block_transfer_request_missing_chunks(void);
 int block_transfer_get_missing_count(void);
 int block_transfer_handle_retransmit_request(const char *request_msg);
+int block_transfer_handle_retransmit_binary(const uint8_t *payload, size_t len);
 void block_transfer_reset_sender(void);
 
 #endif // BLOCK_TRANSFER_H
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// CRC-32 (IEEE 802.3, same polynomial as zlib) computed by the RP2040 DMA
+// sniffer: the data is streamed through a DMA channel with the sniffer
+// attached, so a chunk is checksummed in the time of a memcpy with ~0 CPU
+// cost. Falls back to a software loop if no DMA channel is free.
+
+// Raw accumulator seed for streaming use (crc32_update / crc32_finalize)
+#define CRC32_INIT 0xFFFFFFFFu
+
+// Claim the DMA channel. Safe to call more than once.
+void crc32_init(void);
+
+// One-shot CRC of a buffer (init + update + finalize)
+uint32_t crc32_buffer(const void *data, size_t len);
+
+// Streaming interface: state starts at CRC32_INIT, is fed through
+// crc32_update() one piece at a time (in order), and crc32_finalize()
+// turns the raw accumulator into the standard CRC-32 value.
+uint32_t crc32_update(uint32_t state, const void *data, size_t len);
+uint32_t crc32_finalize(uint32_t state);
+
+#endif // CRC32_H
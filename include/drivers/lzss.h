@@ -0,0 +1,29 @@
+#ifndef LZSS_H
+#define LZSS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Tiny LZSS codec for block-transfer chunks. Each chunk is compressed
+// independently (chunks arrive out of order, so a cross-chunk stream
+// cannot be decoded at the receiver) with the chunk itself as the
+// window - no dictionary RAM beyond the caller's buffers.
+//
+// Encoding: a flag byte followed by up to 8 items. Flag bit clear =
+// 1 literal byte; flag bit set = 2-byte back-reference with a 12-bit
+// offset (1-4096) and a 4-bit length (3-18 bytes).
+
+// Worst case (all literals): one flag byte per 8 input bytes
+#define LZSS_MAX_COMPRESSED(n) ((n) + (((n) + 7) / 8))
+
+// Compress in[0..in_len) into out. Returns the compressed length, or 0
+// if it does not fit in out_max (incompressible - send the raw bytes).
+size_t lzss_compress(const uint8_t *in, size_t in_len,
+                     uint8_t *out, size_t out_max);
+
+// Decompress in[0..in_len) into out. Returns the decompressed length,
+// or 0 on malformed input or output overflow.
+size_t lzss_decompress(const uint8_t *in, size_t in_len,
+                       uint8_t *out, size_t out_max);
+
+#endif // LZSS_H
@@ -0,0 +1,25 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+
+// Lightweight runtime performance counters. Hot paths do nothing but a
+// single aligned-word increment (no locks, no formatting); the formatting
+// and rate math happen only in perf_counters_publish(), called every few
+// seconds from the main loop. Published as one compact key=value line on
+// "pico/stats" so the dashboard can graph a deployed node.
+
+typedef struct {
+    volatile uint32_t chunks_sent;       // Block chunks published (incl. retransmits)
+    volatile uint32_t chunks_received;   // Block chunks accepted by the receiver
+    volatile uint32_t retransmits;       // Chunks resent via the NACK path
+} perf_counters_t;
+
+extern perf_counters_t perf;
+
+// Publish a stats snapshot on pico/stats (QoS 0). Also folds in counters
+// owned elsewhere: UDP RX queue drops, PUBACK RTT EWMA, heap usage
+// high-water mark. Returns the publish result (0 = sent).
+int perf_counters_publish(void);
+
+#endif // PERF_COUNTERS_H
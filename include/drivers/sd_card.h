@@ -18,6 +18,9 @@ int sd_card_init_with_detection(void);
 int sd_card_simple_detect(void);
 int sd_card_read_sector(uint32_t sector, uint8_t *buffer);
 int sd_card_write_sector(uint32_t sector, const uint8_t *buffer);
+// Multi-block transfers (CMD18/CMD25, data phases over DMA)
+int sd_card_read_sectors(uint32_t sector, uint8_t *buffer, uint32_t count);
+int sd_card_write_sectors(uint32_t sector, const uint8_t *buffer, uint32_t count);
 bool sd_card_is_mounted(void);
 bool sd_card_is_initialized(void);  // Hardware initialized (for diskio)
 void sd_card_check_status(void);
@@ -19,11 +19,22 @@
 int wifi_udp_create(uint16_t local_port);
 // Sned UDP packet
 int wifi_udp_send(const char *dest_ip, uint16_t dest_port, const uint8_t *data, size_t len);
+// Zero-copy transmit: claim a pool buffer, serialize into it, then send it.
+// Claim returns NULL if no slot is free (fall back to wifi_udp_send).
+uint8_t *wifi_udp_tx_claim(size_t max_len);
+int wifi_udp_send_claimed(const char *dest_ip, uint16_t dest_port, size_t len);
+void wifi_udp_tx_release(void);
 // Receive UDP packet with timeout (ms). 0 = non-blocking
 int wifi_udp_receive(uint8_t *buffer, size_t max_len, uint32_t timeout_ms);
 // Close UDP socket
 void wifi_udp_close(void);
 // Get UDP connection
 bool is_udp_open(void);
+// Packets dropped because the receive queue was full
+uint32_t wifi_udp_get_rx_dropped(void);
+// Event wait for app loops: blocks until a packet arrives, wifi_udp_notify()
+// is called (ISR-safe), or the timeout elapses. True = woken by an event.
+bool wifi_udp_wait_event(uint32_t timeout_ms);
+void wifi_udp_notify(void);
 
 #endif
\ No newline at end of file
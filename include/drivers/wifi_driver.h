@@ -12,8 +12,10 @@
 
 // Configuration
 #define RECONNECT_CHECK_INTERVAL_MS 5000   // Check connection every 5 seconds
-#define RECONNECT_ATTEMPT_INTERVAL_MS 10000 // Try reconnecting every 10 seconds
+#define RECONNECT_BACKOFF_MIN_MS 500       // First retry after 500ms, then doubling...
+#define RECONNECT_BACKOFF_MAX_MS 10000     // ...up to the old fixed 10s interval
 #define CONNECTION_TIMEOUT_MS 7000         // Wait 7s for connection attempt
+#define DIRECTED_JOIN_TIMEOUT_MS 2000      // Directed rejoin to cached BSSID
 
 // Simple WiFi state with connection time
 typedef struct {
@@ -25,6 +27,7 @@ typedef struct {
     absolute_time_t last_reconnect_time;
     uint32_t reconnect_count;
     uint32_t disconnect_count;
+    uint32_t reconnect_backoff_ms;  // Current retry interval (exponential)
     uint32_t last_connection_time_ms;
     uint32_t fastest_connection_ms;
     uint32_t slowest_connection_ms;
@@ -0,0 +1,51 @@
+// log.h - Compile-time leveled logging
+//
+// LOG_LEVEL selects the most verbose level that is compiled in; anything
+// above it becomes a no-op with zero code generated, so release builds keep
+// stdio entirely out of the per-chunk/per-packet hot path. Override from the
+// build with e.g. target_compile_definitions(... LOG_LEVEL=LOG_LEVEL_TRACE).
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdio.h>
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_TRACE 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) printf(__VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) printf(__VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) printf(__VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_TRACE
+#define LOG_TRACE(...) printf(__VA_ARGS__)
+#else
+#define LOG_TRACE(...) ((void)0)
+#endif
+
+// True when a level is compiled in - guards multi-statement dumps (hex dumps,
+// loops) that would otherwise still execute their formatting work.
+#define LOG_ENABLED(level) (LOG_LEVEL >= (level))
+
+#endif // LOG_H
@@ -13,6 +13,13 @@ int mqttsn_transport_open(uint16_t local_port);
 // Send a datagram to destination IP:port. dest_ip is dotted decimal string.
 int mqttsn_transport_send(const char *dest_ip, uint16_t dest_port, const uint8_t *data, size_t len);
 
+// Zero-copy transmit path: claim a preallocated transmit buffer, serialize
+// the packet into it, then send it without an intermediate copy. Claim
+// returns NULL when no buffer is free; fall back to mqttsn_transport_send.
+uint8_t *mqttsn_transport_tx_claim(size_t max_len);
+int mqttsn_transport_send_claimed(const char *dest_ip, uint16_t dest_port, size_t len);
+void mqttsn_transport_tx_release(void);
+
 // Receive into buffer up to max_len bytes with timeout in ms (0 = non-blocking).
 // Returns number of bytes received (>0), 0 for no data (non-blocking), or negative on error.
 int mqttsn_transport_receive(uint8_t *buffer, size_t max_len, uint32_t timeout_ms);
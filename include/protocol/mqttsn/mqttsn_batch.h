@@ -0,0 +1,55 @@
+// mqttsn_batch.h
+// Publish batching for small telemetry payloads. Each call to
+// mqttsn_demo_publish_name() costs a full serialize + pbuf alloc + send
+// (and at QoS 1 a PUBACK round trip), so high-rate sensor readings spend
+// the loop on per-packet overhead. The batcher coalesces queued payloads
+// for one topic into a single length-prefixed PUBLISH, flushed when the
+// buffer fills or a short deadline passes - N readings cost one packet
+// and one ack instead of N.
+
+#ifndef MQTTSN_BATCH_H
+#define MQTTSN_BATCH_H
+
+#include <stdint.h>
+
+// Batch payload wire format: magic + entry count, then count entries of
+// (uint8 length, bytes). First byte is non-printable so plain text
+// payloads on the same topic can never be mistaken for a batch.
+#define MQTTSN_BATCH_MAGIC 0xB7
+
+#define MQTTSN_BATCH_MAX_BYTES 256  // Whole batch payload budget
+#define MQTTSN_BATCH_DEADLINE_MS 25 // Max time a queued reading waits
+
+typedef struct __attribute__((packed)) {
+    uint8_t magic;  // MQTTSN_BATCH_MAGIC
+    uint8_t count;  // Number of entries that follow
+} mqttsn_batch_header_t;
+
+// Queue a payload for batched publishing on the given topic. Flushes
+// automatically when the buffer fills, when the topic changes, or when
+// the deadline expires (via mqttsn_batch_poll). Payloads too big to
+// batch (> 255 bytes or over the buffer budget) are published directly.
+// Returns 0 on success (queued or sent), negative on publish failure.
+int mqttsn_batch_publish(const char *topicname, const uint8_t *payload, int payloadlen);
+
+// Send the pending batch now, if any. Returns the publish result
+// (0 = sent or nothing pending).
+int mqttsn_batch_flush(void);
+
+// Deadline driver - call every main-loop iteration.
+int mqttsn_batch_poll(void);
+
+// Milliseconds until the pending batch's deadline (0 = overdue), or
+// UINT32_MAX when nothing is queued. Event loops that block between
+// iterations cap their wait with this so a queued batch is flushed
+// near MQTTSN_BATCH_DEADLINE_MS instead of at the next timer wakeup.
+uint32_t mqttsn_batch_wait_ms(void);
+
+// Unbatcher for the subscriber's dispatch path: invokes cb once per entry.
+// Returns the number of entries decoded, 0 if the payload is not a batch
+// (caller handles it as a plain message), or -1 if it is malformed.
+typedef void (*mqttsn_batch_entry_cb)(const uint8_t *payload, int payloadlen, void *user);
+int mqttsn_batch_decode(const uint8_t *payload, int payloadlen,
+                        mqttsn_batch_entry_cb cb, void *user);
+
+#endif // MQTTSN_BATCH_H
@@ -21,4 +21,21 @@ int mqttsn_demo_process_once(uint32_t timeout_ms);
 int mqttsn_get_qos(void);
 void mqttsn_set_qos(int qos);
 
+// Windowed publish engine (QoS 1): keeps several PUBLISHes in flight and
+// completes PUBACKs out of order, so bulk senders (block transfer) are not
+// stop-and-wait limited. Window full is not an error - poll and retry.
+#define MQTTSN_PUBLISH_WINDOW 8     // Max PUBLISHes in flight
+#define MQTTSN_EWINDOWFULL -20      // Window full, poll acks and retry
+#define MQTTSN_MAX_PACKET 1200      // Fits a 1KB negotiated chunk + headers
+
+int mqttsn_publish_window_send(const char *topicname, const uint8_t *payload, int payloadlen);
+int mqttsn_publish_window_poll(uint32_t timeout_ms);
+int mqttsn_publish_window_outstanding(void);
+int mqttsn_publish_window_flush(uint32_t timeout_ms);
+
+// Delivery feedback for adaptive pacing: cumulative count of PUBLISHes
+// resent after an ack timeout, and smoothed PUBACK round-trip time.
+uint32_t mqttsn_publish_window_resends(void);
+uint32_t mqttsn_publish_window_srtt_ms(void);
+
 #endif // MQTTSN_CLIENT_H
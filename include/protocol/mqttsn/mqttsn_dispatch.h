@@ -0,0 +1,37 @@
+#ifndef MQTTSN_DISPATCH_H
+#define MQTTSN_DISPATCH_H
+
+#include <stdint.h>
+
+// Zero-copy RX dispatch: modules register a handler keyed by MQTT-SN
+// message type (and, for PUBLISH, topic ID) and get invoked with const
+// views straight into the receive buffer - no intermediate copies and no
+// per-packet strncmp cascades. The dispatcher owns the receiver-side ack
+// traffic (PUBACK, PUBREC/PUBREL/PUBCOMP) so handlers only see payload.
+//
+// For PUBLISH the view covers just the payload; for every other message
+// type it covers the whole packet (length byte included).
+
+// Matches any topic ID in a PUBLISH registration
+#define MQTTSN_DISPATCH_ANY_TOPIC 0xFFFF
+
+// Fixed handler table - registration fails loudly when it is full
+#define MQTTSN_DISPATCH_HANDLERS 8
+
+typedef void (*mqttsn_handler_t)(const uint8_t *payload, int payloadlen,
+                                 uint16_t topic_id, void *user);
+
+// Register a handler. topic_id is only consulted for PUBLISH (0x0C);
+// pass MQTTSN_DISPATCH_ANY_TOPIC for a catch-all. An exact topic match
+// always wins over a catch-all. Returns 0, or -1 if the table is full.
+int mqttsn_dispatch_register(uint8_t msg_type, uint16_t topic_id,
+                             mqttsn_handler_t handler, void *user);
+
+// Drop every registration (gateway reconnect invalidates topic IDs)
+void mqttsn_dispatch_reset(void);
+
+// Route one received packet. Returns 1 if a registered handler took it,
+// 0 if nothing matched (caller falls back to its default handling).
+int mqttsn_dispatch_packet(const uint8_t *buf, int len);
+
+#endif // MQTTSN_DISPATCH_H
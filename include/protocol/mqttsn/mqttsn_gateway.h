@@ -0,0 +1,53 @@
+// mqttsn_gateway.h
+// Multi-gateway health tracking and failover. The transport destination is
+// no longer the single hard-coded MQTTSN_GATEWAY_IP: a small table holds
+// every configured gateway, lightweight PINGREQ probes measure per-gateway
+// RTT in rotation, and the active gateway is always the lowest-latency one
+// still answering. When the active gateway stops acking, the switch happens
+// within one probe interval instead of stalling every publish on 5-second
+// timeouts.
+
+#ifndef MQTTSN_GATEWAY_H
+#define MQTTSN_GATEWAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MQTTSN_GATEWAYS_MAX 3
+
+// Probe cadence and health thresholds
+#define MQTTSN_GATEWAY_PROBE_MS 10000   // One PINGREQ per interval, round robin
+#define MQTTSN_GATEWAY_PROBE_TIMEOUT_MS 2000
+#define MQTTSN_GATEWAY_PROBE_FAILS 2    // Consecutive misses before marked dead
+
+// Build the table from network_config.h (primary, plus MQTTSN_GATEWAY2_IP /
+// MQTTSN_GATEWAY3_IP when defined). Called lazily by the accessors, so
+// existing code paths need no init call.
+void mqttsn_gateway_init(void);
+
+// Destination for every transport send: the active gateway.
+const char *mqttsn_gateway_ip(void);
+uint16_t mqttsn_gateway_port(void);
+
+// Periodic driver, called from the app main loops. Sends at most one
+// PINGREQ per probe interval (rotating through the table), expires
+// unanswered probes, and fails over when the active gateway goes dead.
+void mqttsn_gateway_tick(void);
+
+// Feed a received PINGRESP into the prober (attributed to the outstanding
+// probe). Call wherever msg type 0x17 is seen.
+void mqttsn_gateway_on_pingresp(void);
+
+// Traffic-level health feedback: call when the active gateway eats an ack
+// timeout (e.g. a window slot exhausts its resends). Counts toward the
+// same failure threshold as missed probes.
+void mqttsn_gateway_report_failure(void);
+
+// True once per failover: the session (CONNECT/REGISTER/SUBSCRIBE) must be
+// re-established against the new gateway. The app loops poll this and drop
+// their session state the same way they do after a Wi-Fi reconnect.
+bool mqttsn_gateway_take_changed(void);
+
+void mqttsn_gateway_print_status(void);
+
+#endif // MQTTSN_GATEWAY_H
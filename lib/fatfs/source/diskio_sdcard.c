@@ -12,6 +12,8 @@
 extern int sd_card_init(void);
 extern int sd_card_read_sector(uint32_t sector, uint8_t *buffer);
 extern int sd_card_write_sector(uint32_t sector, const uint8_t *buffer);
+extern int sd_card_read_sectors(uint32_t sector, uint8_t *buffer, uint32_t count);
+extern int sd_card_write_sectors(uint32_t sector, const uint8_t *buffer, uint32_t count);
 extern bool sd_card_is_initialized(void);  // Check hardware only, not filesystem
 
 /*-----------------------------------------------------------------------*/
@@ -54,12 +56,11 @@ DRESULT disk_read (
     if (pdrv != 0) return RES_PARERR;
     if (!sd_card_is_initialized()) return RES_NOTRDY;
     
-    for (UINT i = 0; i < count; i++) {
-        if (sd_card_read_sector(sector + i, buff + (i * 512)) != 0) {
-            return RES_ERROR;
-        }
+    // Whole run in one CMD18 (falls back to CMD17 internally for count == 1)
+    if (sd_card_read_sectors(sector, buff, count) != 0) {
+        return RES_ERROR;
     }
-    
+
     return RES_OK;
 }
 
@@ -77,12 +78,11 @@ DRESULT disk_write (
     if (pdrv != 0) return RES_PARERR;
     if (!sd_card_is_initialized()) return RES_NOTRDY;
     
-    for (UINT i = 0; i < count; i++) {
-        if (sd_card_write_sector(sector + i, buff + (i * 512)) != 0) {
-            return RES_ERROR;
-        }
+    // Whole run in one CMD25 (falls back to CMD24 internally for count == 1)
+    if (sd_card_write_sectors(sector, buff, count) != 0) {
+        return RES_ERROR;
     }
-    
+
     return RES_OK;
 }
 #endif
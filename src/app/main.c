@@ -9,13 +9,17 @@
 #include "ff.h"
 
 // Custom header files
+#include "app/startup.h"
 #include "config/network_config.h"
 #include "drivers/wifi_driver.h"
 #include "drivers/udp_driver.h"
 #include "net/network_errors.h"
 #include "protocol/mqttsn/mqttsn_client.h"
 #include "protocol/mqttsn/mqttsn_adapter.h"
+#include "protocol/mqttsn/mqttsn_batch.h"
+#include "protocol/mqttsn/mqttsn_gateway.h"
 #include "drivers/block_transfer.h"
+#include "drivers/perf_counters.h"
 #include "drivers/sd_card.h"
 
 #ifdef HAVE_PAHO
@@ -31,25 +35,37 @@ static uint32_t last_wifi_wait_print = 0;
 
 // Button debouncing
 static volatile uint32_t last_button_press = 0;
-static uint32_t last_block_transfer_button_press = 0;
+static volatile uint32_t last_block_transfer_button_press = 0;
+static volatile bool block_transfer_requested = false;
 static const uint32_t DEBOUNCE_MS = 300;
 
-// GPIO interrupt handler for button
+// GPIO interrupt handler for buttons. Both buttons wake the event loop via
+// wifi_udp_notify() so a press is handled immediately, not on the next poll.
 void gpio_callback(uint gpio, uint32_t events) {
     if (gpio == QOS_TOGGLE && (events & GPIO_IRQ_EDGE_FALL)) {
         uint32_t now = to_ms_since_boot(get_absolute_time());
-        
+
         // Debounce check
         if (now - last_button_press > DEBOUNCE_MS) {
             last_button_press = now;
-            
+
             // Toggle QoS level: 0 -> 1 -> 2 -> 0
             int current_qos = mqttsn_get_qos();
             int next_qos = (current_qos + 1) % 3;
             mqttsn_set_qos(next_qos);
-            
+
             printf("\n[BUTTON] QoS level changed: %d -> %d\n", current_qos, next_qos);
             printf("[INFO] Next publish will use QoS %d\n", next_qos);
+            wifi_udp_notify();
+        }
+    }
+
+    if (gpio == BLOCK_TRANSFER && (events & GPIO_IRQ_EDGE_FALL)) {
+        uint32_t now = to_ms_since_boot(get_absolute_time());
+        if (now - last_block_transfer_button_press > DEBOUNCE_MS) {
+            last_block_transfer_button_press = now;
+            block_transfer_requested = true;  // Transfer runs from the main loop
+            wifi_udp_notify();
         }
     }
 }
@@ -62,6 +78,13 @@ static bool app_init_sd_card_once(void){
         return true;
     }
 
+    // The boot orchestrator usually has the card ready already (core 1,
+    // overlapped with Wi-Fi association) - join that first
+    if (startup_sd_join(8000) == 0) {
+        initialised = true;
+        return true;
+    }
+
     printf("[SD] Initialising SD card...\n");
     if(sd_card_init_with_detection() != 0){
         printf("[SD] SD card hardware initialisation failed.\n");
@@ -72,20 +95,17 @@ static bool app_init_sd_card_once(void){
         printf("[SD] FAT32 mount failed.\n");
         return false;
     }
-    
+
     printf("[SD] SD card initalised and FAT32 mounted!\n");
     initialised = true;
     return true;
 }
 
-// Simple poll-based check for GP21
+// Consume the GP21 press latched by the interrupt handler
 static bool block_transfer_button_pressed(void){
-    uint32_t now = to_ms_since_boot(get_absolute_time());
-    if (gpio_get(BLOCK_TRANSFER) == 0){
-        if (now - last_block_transfer_button_press > DEBOUNCE_MS) {
-            last_block_transfer_button_press = now;
-            return true;
-        }
+    if (block_transfer_requested) {
+        block_transfer_requested = false;
+        return true;
     }
     return false;
 }
@@ -115,7 +135,7 @@ static void app_start_block_transfer(void){
     // Reset sender state from previous transfer
     block_transfer_reset_sender();
 
-    int rc = send_image_file_qos(topic, filename, (uint8_t)qos);
+    int rc = send_image_file_delta(topic, filename, (uint8_t)qos);
     if (rc == 0){
         printf("[APP] ✓ Block Transfer completed successfully\n");
         printf("[APP] Image '%s' sent to GitHub repo\n", filename);
@@ -136,6 +156,7 @@ void buttons_init() {
 
     // Enable interrupt on falling edge (button press)
     gpio_set_irq_enabled_with_callback(QOS_TOGGLE, GPIO_IRQ_EDGE_FALL, true, &gpio_callback);
+    gpio_set_irq_enabled(BLOCK_TRANSFER, GPIO_IRQ_EDGE_FALL, true);  // Same callback
 }
 
 // Check for incoming messages (can be called from anywhere, including during block transfer)
@@ -166,15 +187,18 @@ int mqttsn_check_incoming_messages(void) {
                                          &topic, &payload, &payloadlen, 
                                          recv_buf, recv_rc) == 1) {
                 
-                // Check if this is a retransmit request
-                if (payloadlen >= 5 && strncmp((char*)payload, "NACK:", 5) == 0) {
+                // Check if this is a retransmit request (binary SACK or ASCII NACK)
+                if (payloadlen >= 1 && payload[0] == BLOCK_SACK_MAGIC) {
+                    printf("\n[PUBLISHER] 📩 SACK received during transfer!\n");
+                    block_transfer_handle_retransmit_binary(payload, payloadlen);
+                } else if (payloadlen >= 5 && strncmp((char*)payload, "NACK:", 5) == 0) {
                     printf("\n[PUBLISHER] 📩 NACK received during transfer!\n");
-                    
+
                     char request_msg[256];
                     int copy_len = (payloadlen < 255) ? payloadlen : 255;
                     memcpy(request_msg, payload, copy_len);
                     request_msg[copy_len] = '\0';
-                    
+
                     block_transfer_handle_retransmit_request(request_msg);
                 }
                 
@@ -188,7 +212,7 @@ int mqttsn_check_incoming_messages(void) {
                     puback_buf[4] = (msgid >> 8);
                     puback_buf[5] = (msgid & 0xFF);
                     puback_buf[6] = 0x00;
-                    mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, 
+                    mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(), 
                                          puback_buf, sizeof(puback_buf));
                 }
             }
@@ -202,10 +226,15 @@ int mqttsn_check_incoming_messages(void) {
 
 int main(){
     stdio_init_all();
-    sleep_ms(3000); // Provide time for serial monitor to connect
 
     printf("\n=== MQTT-SN Pico W Client Starting ===\n");
 
+    // Kick the slow SD command sequence off on core 1 right away; core 0
+    // overlaps it with radio bring-up and association. (The old 3-second
+    // serial-monitor sleep is gone - battery nodes reboot often and the
+    // 30-second stats print repeats anything a late monitor missed.)
+    startup_begin();
+
     // ========================= Button Setup =========================
     buttons_init();
     
@@ -220,6 +249,8 @@ int main(){
 
     if (wifi_connect() != 0) {
         printf("[WARNING] Initial connection failed - will retry automatically\n");
+    } else {
+        startup_mark("Wi-Fi associated");
     }
 
     block_transfer_init();
@@ -261,6 +292,25 @@ int main(){
         // 3. WiFi Connected
         if (is_connected){
 
+            // Gateway health: probe RTTs in rotation and, if the prober
+            // failed over, rebuild the session against the new gateway
+            if (mqtt_demo_started) {
+                // Flush any queued telemetry batch past its deadline; a
+                // failed flush means the gateway path is broken
+                if (mqttsn_batch_poll() != 0) {
+                    printf("[MQTTSN] ✗ Batch flush failed - reconnecting\n");
+                    mqtt_demo_started = false;
+                    mqttsn_demo_close();
+                }
+                mqttsn_gateway_tick();
+                if (mqttsn_gateway_take_changed()) {
+                    printf("[MQTT-SN] Gateway changed - re-establishing session...\n");
+                    mqtt_demo_started = false;
+                    subscribed_to_retransmit = false;
+                    mqttsn_demo_close();
+                }
+            }
+
             if (!mqtt_demo_started){
                 printf("\n[MQTT-SN] Initializing MQTT-SN Demo...\n");
                 
@@ -268,6 +318,7 @@ int main(){
                 // Modify mqttsn_client.c to accept client ID parameter
                 if (mqttsn_demo_init(0, "pico_w_publisher") == 0) {
                     printf("[MQTT-SN] ✓ MQTT-SN Demo initialized successfully\n");
+                    startup_mark("Ready to publish");
                     
                     // Subscribe to retransmit requests from subscriber
                     printf("[MQTT-SN] Subscribing to retransmit topic...\n");
@@ -324,17 +375,20 @@ int main(){
                             printf("[PUBLISHER] PUBLISH decoded: TopicID=%u, QoS=%d, PayloadLen=%d\n",
                                    topic.data.id, qos, payloadlen);
                             
-                            // Check if this is a retransmit request
-                            if (payloadlen >= 5 && strncmp((char*)payload, "NACK:", 5) == 0) {
+                            // Check if this is a retransmit request (binary SACK or ASCII NACK)
+                            if (payloadlen >= 1 && payload[0] == BLOCK_SACK_MAGIC) {
+                                printf("\n[PUBLISHER] 📩 SACK request received!\n");
+                                block_transfer_handle_retransmit_binary(payload, payloadlen);
+                            } else if (payloadlen >= 5 && strncmp((char*)payload, "NACK:", 5) == 0) {
                                 printf("\n[PUBLISHER] 📩 NACK request received!\n");
                                 printf("[PUBLISHER] Payload: %.*s\n", payloadlen, payload);
-                                
+
                                 // Null-terminate payload for string processing
                                 char request_msg[256];
                                 int copy_len = (payloadlen < 255) ? payloadlen : 255;
                                 memcpy(request_msg, payload, copy_len);
                                 request_msg[copy_len] = '\0';
-                                
+
                                 // Handle the retransmit request
                                 block_transfer_handle_retransmit_request(request_msg);
                             } else {
@@ -352,7 +406,7 @@ int main(){
                                 puback_buf[4] = (msgid >> 8);
                                 puback_buf[5] = (msgid & 0xFF);
                                 puback_buf[6] = 0x00;
-                                mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, 
+                                mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(), 
                                                      puback_buf, sizeof(puback_buf));
                                 printf("[PUBLISHER] PUBACK sent for MsgID=%u\n", msgid);
                             }
@@ -362,8 +416,10 @@ int main(){
                         #endif
                     } else if (msg_type == 0x16) {  // PINGREQ
                         unsigned char pingresp[] = {0x02, 0x17};
-                        mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, 
+                        mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(),
                                              pingresp, sizeof(pingresp));
+                    } else if (msg_type == 0x17) {  // PINGRESP - gateway RTT probe
+                        mqttsn_gateway_on_pingresp();
                     } else if (msg_type == 0x18) {  // DISCONNECT
                         printf("[MQTTSN] Connection lost - will reconnect...\n");
                         mqtt_demo_started = false;
@@ -383,18 +439,22 @@ int main(){
                     snprintf(msg, sizeof(msg), "Hello from Pico W #%lu (QoS%d)", message_count++, qos);
                     
                     printf("\n[MQTTSN] >>> Publishing message #%lu with QoS %d <<<\n", message_count, qos);
-                    
-                    uint32_t pub_start = to_ms_since_boot(get_absolute_time());
-                    int pub_result = mqttsn_demo_publish_name("pico/test", (const uint8_t*)msg, (int)strlen(msg));
-                    uint32_t pub_end = to_ms_since_boot(get_absolute_time());
-                    
+
+                    // Through the batcher: at this 5s cadence each message
+                    // flushes alone on the deadline, but bursty telemetry
+                    // (e.g. sensor loops) coalesces automatically
+                    int pub_result = mqttsn_batch_publish("pico/test", (const uint8_t*)msg, (int)strlen(msg));
+
                     if (pub_result == 0) {
-                        printf("[MQTTSN] ✓ SUCCESS: Message published (latency=%lums)\n", pub_end - pub_start);
+                        printf("[MQTTSN] ✓ Message queued for publish\n");
                     } else {
                         printf("[MQTTSN] ✗ WARNING: Publish failed (rc=%d)\n", pub_result);
                         mqtt_demo_started = false;
                         mqttsn_demo_close();
                     }
+
+                    // Piggyback the perf counter snapshot on the same cadence
+                    perf_counters_publish();
                     last_publish = now_ms;
                 }
 
@@ -417,6 +477,7 @@ int main(){
         if (absolute_time_diff_us(last_status_print, get_absolute_time()) > 30000000) {
             printf("\n=== System Statistics ===\n");
             wifi_print_stats();
+            mqttsn_gateway_print_status();
             printf("MQTT-SN Status: %s\n", mqtt_demo_started ? "Connected" : "Disconnected");
             printf("Current QoS Level: %d\n", mqttsn_get_qos());
             if (mqtt_demo_started) {
@@ -427,7 +488,25 @@ int main(){
             sleep_ms(3000);
         }
 
-        sleep_ms(10);
+        // Block until a packet or button event, or the next timer deadline -
+        // replaces the fixed 10ms poll-sleep, so packet-to-processing latency
+        // is set by the event, not the polling period
+        uint32_t wait_ms = 1000;  // Upper bound: reconnect/status housekeeping
+        if (is_connected && mqtt_demo_started) {
+            uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+            uint32_t elapsed = now_ms - last_publish;
+            uint32_t until_publish = (elapsed < 5000) ? (5000 - elapsed) : 0;
+            if (until_publish < wait_ms) wait_ms = until_publish;
+
+            // A queued telemetry batch is flushed by mqttsn_batch_poll()
+            // at the top of the loop; cap the wait at its deadline
+            // remainder so it isn't stuck behind the publish timer
+            uint32_t until_batch = mqttsn_batch_wait_ms();
+            if (until_batch < wait_ms) wait_ms = until_batch;
+        }
+        if (wait_ms > 0) {
+            wifi_udp_wait_event(wait_ms);
+        }
     }
 
     mqttsn_demo_close();
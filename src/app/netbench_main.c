@@ -0,0 +1,318 @@
+// netbench_main.c
+// Scripted benchmark firmware (picow_netbench target): measures the stack
+// the same way the real apps use it and reports min/p50/p99/max for each
+// scenario, so a perf change can be verified on-device before flashing
+// the fleet instead of eyeballing printf timestamps.
+//
+// Scenarios:
+//   1. Gateway RTT         - PINGREQ/PINGRESP round trips over UDP
+//   2. Publish latency     - per-publish time at QoS 0/1/2 across payload sizes
+//   3. SD card throughput  - sd_card_write_file / sd_card_read_file MB/s
+//   4. Block transfer      - end-to-end goodput of send_block_transfer_qos
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+
+#include "config/network_config.h"
+#include "drivers/wifi_driver.h"
+#include "drivers/udp_driver.h"
+#include "drivers/sd_card.h"
+#include "drivers/block_transfer.h"
+#include "protocol/mqttsn/mqttsn_client.h"
+#include "protocol/mqttsn/mqttsn_adapter.h"
+#include "protocol/mqttsn/mqttsn_gateway.h"
+
+// Iteration counts (bump for tighter percentiles, at the cost of runtime)
+#define NETBENCH_RTT_ITERS       100
+#define NETBENCH_PUB_ITERS       50
+#define NETBENCH_SD_ITERS        10
+#define NETBENCH_BLOCK_ITERS     3
+
+#define NETBENCH_SD_FILE_BYTES   (32 * 1024)
+#define NETBENCH_BLOCK_BYTES     (32 * 1024)
+
+#define NETBENCH_MAX_SAMPLES     NETBENCH_RTT_ITERS
+
+static const size_t pub_payload_sizes[] = {32, 128, 512};
+
+// ============================================================================
+// SAMPLE SERIES AND PERCENTILE REPORTING
+// ============================================================================
+
+typedef struct {
+    uint32_t samples[NETBENCH_MAX_SAMPLES];  // Microseconds
+    int count;
+} bench_series_t;
+
+static void series_reset(bench_series_t *s) {
+    s->count = 0;
+}
+
+static void series_add(bench_series_t *s, uint32_t sample_us) {
+    if (s->count < NETBENCH_MAX_SAMPLES) {
+        s->samples[s->count++] = sample_us;
+    }
+}
+
+// Insertion sort - sample counts are small and this needs no allocation
+static void series_sort(bench_series_t *s) {
+    for (int i = 1; i < s->count; i++) {
+        uint32_t v = s->samples[i];
+        int j = i - 1;
+        while (j >= 0 && s->samples[j] > v) {
+            s->samples[j + 1] = s->samples[j];
+            j--;
+        }
+        s->samples[j + 1] = v;
+    }
+}
+
+static uint32_t series_percentile(const bench_series_t *s, int pct) {
+    int idx = (s->count * pct) / 100;
+    if (idx >= s->count) idx = s->count - 1;
+    return s->samples[idx];
+}
+
+static void series_report(const char *label, bench_series_t *s) {
+    if (s->count == 0) {
+        printf("[NETBENCH] %-28s no samples\n", label);
+        return;
+    }
+    series_sort(s);
+    printf("[NETBENCH] %-28s n=%-4d min=%luus p50=%luus p99=%luus max=%luus\n",
+           label, s->count,
+           s->samples[0],
+           series_percentile(s, 50),
+           series_percentile(s, 99),
+           s->samples[s->count - 1]);
+}
+
+// ============================================================================
+// SCENARIO 1: GATEWAY RTT
+// ============================================================================
+
+// PINGREQ/PINGRESP is the closest thing to a UDP echo the gateway offers,
+// and it exercises the same socket path every MQTT-SN exchange uses.
+static void bench_gateway_rtt(void) {
+    bench_series_t series;
+    series_reset(&series);
+
+    printf("\n[NETBENCH] --- Gateway RTT (%d PINGREQs) ---\n", NETBENCH_RTT_ITERS);
+
+    int lost = 0;
+    for (int i = 0; i < NETBENCH_RTT_ITERS; i++) {
+        unsigned char pingreq[] = {0x02, 0x16};
+        unsigned char buf[32];
+
+        uint32_t start = time_us_32();
+        if (mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(),
+                                  pingreq, sizeof(pingreq)) != 0) {
+            lost++;
+            continue;
+        }
+
+        int rc = mqttsn_transport_receive(buf, sizeof(buf), 1000);
+        if (rc > 1 && buf[1] == 0x17) {  // PINGRESP
+            series_add(&series, time_us_32() - start);
+        } else {
+            lost++;
+        }
+        sleep_ms(10);  // Don't measure back-to-back queueing
+    }
+
+    series_report("gateway RTT", &series);
+    if (lost > 0) {
+        printf("[NETBENCH] ⚠️  %d/%d pings lost or timed out\n", lost, NETBENCH_RTT_ITERS);
+    }
+}
+
+// ============================================================================
+// SCENARIO 2: PUBLISH LATENCY ACROSS QoS AND PAYLOAD SIZE
+// ============================================================================
+
+static void bench_publish(void) {
+    static uint8_t payload[512];
+    for (size_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = 'A' + (i % 26);
+    }
+
+    int prev_qos = mqttsn_get_qos();
+
+    for (int qos = 0; qos <= 2; qos++) {
+        for (size_t si = 0; si < count_of(pub_payload_sizes); si++) {
+            size_t size = pub_payload_sizes[si];
+            bench_series_t series;
+            series_reset(&series);
+
+            printf("\n[NETBENCH] --- Publish QoS %d, %zu bytes (%d iters) ---\n",
+                   qos, size, NETBENCH_PUB_ITERS);
+
+            mqttsn_set_qos(qos);
+            uint32_t batch_start = time_us_32();
+            int failures = 0;
+
+            for (int i = 0; i < NETBENCH_PUB_ITERS; i++) {
+                uint32_t start = time_us_32();
+                int rc = mqttsn_demo_publish_name("pico/test", payload, size);
+                if (rc == 0) {
+                    series_add(&series, time_us_32() - start);
+                } else {
+                    failures++;
+                }
+            }
+
+            uint32_t batch_us = time_us_32() - batch_start;
+
+            char label[48];
+            snprintf(label, sizeof(label), "publish QoS%d %zuB", qos, size);
+            series_report(label, &series);
+
+            if (series.count > 0 && batch_us > 0) {
+                float kbps = (series.count * size * 8.0f * 1000.0f) / batch_us;
+                printf("[NETBENCH] %-28s %.2f kbps (%d ok, %d failed)\n",
+                       "  throughput", kbps, series.count, failures);
+            }
+        }
+    }
+
+    mqttsn_set_qos(prev_qos);
+}
+
+// ============================================================================
+// SCENARIO 3: SD CARD FILE THROUGHPUT
+// ============================================================================
+
+static void bench_sd_card(void) {
+    static uint8_t file_buf[NETBENCH_SD_FILE_BYTES];
+    for (size_t i = 0; i < sizeof(file_buf); i++) {
+        file_buf[i] = (uint8_t)i;
+    }
+
+    printf("\n[NETBENCH] --- SD card, %dKB file (%d iters) ---\n",
+           NETBENCH_SD_FILE_BYTES / 1024, NETBENCH_SD_ITERS);
+
+    bench_series_t write_series, read_series;
+    series_reset(&write_series);
+    series_reset(&read_series);
+
+    for (int i = 0; i < NETBENCH_SD_ITERS; i++) {
+        uint32_t start = time_us_32();
+        if (sd_card_write_file("nbench.bin", file_buf, sizeof(file_buf)) == 0) {
+            series_add(&write_series, time_us_32() - start);
+        }
+
+        size_t actual = 0;
+        start = time_us_32();
+        if (sd_card_read_file("nbench.bin", file_buf, sizeof(file_buf), &actual) == 0 &&
+            actual == sizeof(file_buf)) {
+            series_add(&read_series, time_us_32() - start);
+        }
+    }
+
+    series_report("SD write 32KB", &write_series);
+    series_report("SD read 32KB", &read_series);
+
+    if (write_series.count > 0) {
+        // p50 duration -> MB/s (series is already sorted by the report)
+        float mbps = (float)NETBENCH_SD_FILE_BYTES / series_percentile(&write_series, 50);
+        printf("[NETBENCH] %-28s %.2f MB/s (p50)\n", "  write throughput", mbps);
+    }
+    if (read_series.count > 0) {
+        float mbps = (float)NETBENCH_SD_FILE_BYTES / series_percentile(&read_series, 50);
+        printf("[NETBENCH] %-28s %.2f MB/s (p50)\n", "  read throughput", mbps);
+    }
+}
+
+// ============================================================================
+// SCENARIO 4: BLOCK TRANSFER GOODPUT
+// ============================================================================
+
+static void bench_block_transfer(void) {
+    static uint8_t block_buf[NETBENCH_BLOCK_BYTES];
+    for (size_t i = 0; i < sizeof(block_buf); i++) {
+        block_buf[i] = (uint8_t)(i * 7);
+    }
+
+    printf("\n[NETBENCH] --- Block transfer, %dKB at QoS 1 (%d iters) ---\n",
+           NETBENCH_BLOCK_BYTES / 1024, NETBENCH_BLOCK_ITERS);
+
+    bench_series_t series;
+    series_reset(&series);
+
+    for (int i = 0; i < NETBENCH_BLOCK_ITERS; i++) {
+        uint32_t start = time_us_32();
+        if (send_block_transfer_qos("pico/chunks", block_buf, sizeof(block_buf), 1) == 0) {
+            series_add(&series, time_us_32() - start);
+        }
+        block_transfer_reset_sender();
+        sleep_ms(500);  // Let the receiver settle between runs
+    }
+
+    series_report("block transfer 32KB", &series);
+    if (series.count > 0) {
+        float kbps = (NETBENCH_BLOCK_BYTES * 8.0f * 1000.0f) / series_percentile(&series, 50);
+        printf("[NETBENCH] %-28s %.2f kbps goodput (p50)\n", "  goodput", kbps);
+    }
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+int main() {
+    stdio_init_all();
+    sleep_ms(3000);
+
+    printf("\n=== Pico W Network Benchmark ===\n");
+
+    if (wifi_init(WIFI_SSID, WIFI_PASSWORD) != 0) {
+        printf("[ERROR] WiFi initialization failed\n");
+        return 1;
+    }
+
+    while (wifi_connect() != 0) {
+        printf("[NETBENCH] WiFi connection failed, retrying...\n");
+        sleep_ms(5000);
+    }
+    sleep_ms(2000);
+
+    printf("\n[NETBENCH] Connecting to MQTT-SN gateway...\n");
+    while (mqttsn_demo_init(0, "pico_w_netbench") != 0) {
+        printf("[NETBENCH] Gateway connection failed, retrying...\n");
+        sleep_ms(5000);
+    }
+    printf("[NETBENCH] ✓ Connected to gateway\n");
+
+    bool sd_ok = false;
+    if (sd_card_init_with_detection() == 0 && sd_card_mount_fat32() == 0) {
+        printf("[NETBENCH] ✓ SD card mounted\n");
+        sd_ok = true;
+    } else {
+        printf("[NETBENCH] ⚠️  No SD card - skipping SD and block scenarios\n");
+    }
+
+    block_transfer_init();
+
+    bench_gateway_rtt();
+    bench_publish();
+    if (sd_ok) {
+        bench_sd_card();
+        bench_block_transfer();
+    }
+
+    printf("\n[NETBENCH] ✓ All scenarios complete\n");
+
+    // Keep the connection alive so the run can be repeated from a serial
+    // terminal power cycle without the gateway timing the client out
+    while (true) {
+        unsigned char pingreq[] = {0x02, 0x16};
+        mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(),
+                              pingreq, sizeof(pingreq));
+        wifi_udp_wait_event(30000);
+    }
+
+    return 0;
+}
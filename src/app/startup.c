@@ -0,0 +1,77 @@
+// startup.c - boot orchestrator (see include/app/startup.h)
+// Core 1 runs the SD card's init and mount while core 0 associates to
+// Wi-Fi. The card and the radio are on separate buses (SPI vs the CYW43's
+// own interface), so the only shared resource is stdout, which the SDK
+// already serializes. startup_sd_join() resets core 1 afterwards so the
+// subscriber's block pipeline can claim it.
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "app/startup.h"
+#include "drivers/sd_card.h"
+
+static uint32_t boot_t0 = 0;
+static volatile bool sd_running = false;
+static volatile bool sd_launched = false;
+static volatile int sd_result = STARTUP_ETIMEOUT;
+
+static void startup_sd_core1_entry(void) {
+    int rc = 0;
+    if (sd_card_init_with_detection() != 0) {
+        rc = STARTUP_ESDINIT;
+    } else if (sd_card_mount_fat32() != 0) {
+        rc = STARTUP_ESDMOUNT;
+    }
+    sd_result = rc;
+    sd_running = false;
+
+    // Park until core 0 joins and resets this core
+    while (true) {
+        tight_loop_contents();
+    }
+}
+
+void startup_begin(void) {
+    boot_t0 = to_ms_since_boot(get_absolute_time());
+    sd_running = true;
+    sd_launched = true;
+    multicore_launch_core1(startup_sd_core1_entry);
+    printf("[BOOT] SD init started on core 1, bringing up Wi-Fi on core 0\n");
+}
+
+bool startup_sd_busy(void) {
+    return sd_running;
+}
+
+int startup_sd_join(uint32_t timeout_ms) {
+    if (!sd_launched) {
+        return STARTUP_ETIMEOUT;
+    }
+
+    uint32_t start = to_ms_since_boot(get_absolute_time());
+    while (sd_running &&
+           (to_ms_since_boot(get_absolute_time()) - start) < timeout_ms) {
+        sleep_ms(5);
+    }
+
+    // Free core 1 whether the init finished or hung mid-command; a failed
+    // result falls back to a fresh synchronous init, which reprograms the
+    // SPI block from scratch anyway
+    multicore_reset_core1();
+    sd_launched = false;
+
+    int rc = sd_running ? STARTUP_ETIMEOUT : sd_result;
+    sd_running = false;
+    if (rc == 0) {
+        startup_mark("SD card ready (core 1)");
+    } else {
+        printf("[BOOT] ⚠️  Background SD init failed (rc=%d)\n", rc);
+    }
+    return rc;
+}
+
+void startup_mark(const char *stage) {
+    printf("[BOOT] %s at %lu ms\n", stage,
+           (unsigned long)(to_ms_since_boot(get_absolute_time()) - boot_t0));
+}
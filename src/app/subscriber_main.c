@@ -5,11 +5,18 @@
 #include "pico/cyw43_arch.h"
 #include "hardware/gpio.h"
 
+#include "app/startup.h"
 #include "config/network_config.h"
 #include "drivers/wifi_driver.h"
+#include "drivers/udp_driver.h"
 #include "protocol/mqttsn/mqttsn_client.h"
 #include "protocol/mqttsn/mqttsn_adapter.h"
+#include "protocol/mqttsn/mqttsn_batch.h"
+#include "protocol/mqttsn/mqttsn_gateway.h"
+#include "protocol/mqttsn/mqttsn_dispatch.h"
 #include "drivers/block_transfer.h"
+#include "drivers/block_pipeline.h"
+#include "drivers/perf_counters.h"
 #include "drivers/sd_card.h"
 
 #ifdef HAVE_PAHO
@@ -26,97 +33,78 @@ static bool mqtt_subscriber_ready = false;
 static unsigned short subscribed_topicid = 0;
 static unsigned short chunks_topicid = 0;
 
-// Process received PUBLISH messages
-static void process_publish_message(unsigned char *buf, int len) {
-    #ifdef HAVE_PAHO
-    unsigned char dup, retained;
-    unsigned short msgid;
-    int qos;
-    MQTTSN_topicid topic;
-    unsigned char *payload;
-    int payloadlen;
-    
-    int rc = MQTTSNDeserialize_publish(&dup, &qos, &retained, &msgid, 
-                                       &topic, &payload, &payloadlen, 
-                                       buf, len);
-    
-    if (rc == 1) {
-        // Check if this is a block chunk (from pico/chunks topic)
-        if (chunks_topicid > 0 && topic.data.id == chunks_topicid) {
-            // Process block chunks with safety check
-            if (payload && payloadlen > 0) {
-                process_block_chunk(payload, payloadlen);
-            } else {
-                printf("[SUBSCRIBER] ✗ Invalid chunk: payload=%p, len=%d\n", payload, payloadlen);
-            }
-        } else {
-            // Regular message - print details
-            printf("\n[SUBSCRIBER] ✓ Message received:\n");
-            printf("  TopicID: %u\n", topic.data.id);
-            printf("  QoS: %d\n", qos);
-            printf("  MsgID: %u\n", msgid);
-            printf("  Payload (%d bytes)\n", payloadlen);
-            // Regular message - print as text
-            printf("  Message: ");
-            for (int i = 0; i < payloadlen; i++) {
-                printf("%c", payload[i]);
-            }
-            printf("\n");
-        }
-        
-        // Send PUBACK for QoS 1
-        if (qos == 1) {
-            unsigned char puback_buf[7];
-            puback_buf[0] = 7;              // Length
-            puback_buf[1] = 0x0D;           // PUBACK
-            puback_buf[2] = (topic.data.id >> 8);
-            puback_buf[3] = (topic.data.id & 0xFF);
-            puback_buf[4] = (msgid >> 8);
-            puback_buf[5] = (msgid & 0xFF);
-            puback_buf[6] = 0x00;           // Return code (accepted)
-            
-            mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, 
-                                 puback_buf, sizeof(puback_buf));
-        }
-        
-        // Send PUBREC for QoS 2
-        if (qos == 2) {
-            unsigned char pubrec_buf[4];
-            pubrec_buf[0] = 4;              // Length
-            pubrec_buf[1] = 0x0F;           // PUBREC
-            pubrec_buf[2] = (msgid >> 8);
-            pubrec_buf[3] = (msgid & 0xFF);
-            
-            mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, 
-                                 pubrec_buf, sizeof(pubrec_buf));
-            printf("[SUBSCRIBER] → PUBREC sent (MsgID=%u)\n", msgid);
-            
-            // Wait for PUBREL
-            printf("[SUBSCRIBER] Waiting for PUBREL...\n");
-            unsigned char pubrel_buf[256];
-            int pubrel_rc = mqttsn_transport_receive(pubrel_buf, sizeof(pubrel_buf), 5000);
-            
-            if (pubrel_rc > 0 && pubrel_buf[1] == 0x10) {  // 0x10 = PUBREL
-                printf("[SUBSCRIBER] ✓ PUBREL received\n");
-                
-                // Send PUBCOMP
-                unsigned char pubcomp_buf[4];
-                pubcomp_buf[0] = 4;              // Length
-                pubcomp_buf[1] = 0x0E;           // PUBCOMP
-                pubcomp_buf[2] = (msgid >> 8);
-                pubcomp_buf[3] = (msgid & 0xFF);
-                
-                mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, 
-                                     pubcomp_buf, sizeof(pubcomp_buf));
-                printf("[SUBSCRIBER] → PUBCOMP sent (MsgID=%u) - QoS 2 complete\n", msgid);
-            } else {
-                printf("[SUBSCRIBER] ✗ PUBREL not received\n");
-            }
-        }
+// ---- Dispatch handlers -----------------------------------------------------
+// Registered with mqttsn_dispatch after subscribing; each gets a const
+// view straight into the receive buffer and the dispatcher sends the acks.
+
+static void on_chunk_publish(const uint8_t *payload, int payloadlen,
+                             uint16_t topic_id, void *user) {
+    (void)topic_id; (void)user;
+    if (payload == NULL || payloadlen <= 0) {
+        printf("[SUBSCRIBER] ✗ Invalid chunk: payload=%p, len=%d\n", payload, payloadlen);
+        return;
+    }
+    // Hand the chunk to core 1 so SD writes never stall the receive
+    // path; fall back to inline processing otherwise
+    if (block_pipeline_active()) {
+        block_pipeline_submit_chunk(payload, payloadlen);
     } else {
-        printf("[SUBSCRIBER] Failed to deserialize PUBLISH\n");
+        process_block_chunk(payload, payloadlen);
     }
-    #endif
+}
+
+static void on_batched_reading(const uint8_t *payload, int payloadlen, void *user) {
+    (void)user;
+    printf("  Reading: ");
+    for (int i = 0; i < payloadlen; i++) {
+        printf("%c", payload[i]);
+    }
+    printf("\n");
+}
+
+static void on_default_publish(const uint8_t *payload, int payloadlen,
+                               uint16_t topic_id, void *user) {
+    (void)user;
+
+    // Coalesced telemetry: one PUBLISH can carry several readings
+    if (payloadlen >= 1 && payload[0] == MQTTSN_BATCH_MAGIC) {
+        printf("\n[SUBSCRIBER] ✓ Batched readings (TopicID=%u):\n", topic_id);
+        if (mqttsn_batch_decode(payload, payloadlen, on_batched_reading, NULL) < 0) {
+            printf("[SUBSCRIBER] ✗ Malformed batch dropped\n");
+        }
+        return;
+    }
+
+    printf("\n[SUBSCRIBER] ✓ Message received:\n");
+    printf("  TopicID: %u\n", topic_id);
+    printf("  Payload (%d bytes)\n", payloadlen);
+    printf("  Message: ");
+    for (int i = 0; i < payloadlen; i++) {
+        printf("%c", payload[i]);
+    }
+    printf("\n");
+}
+
+static void on_pingreq(const uint8_t *payload, int payloadlen,
+                       uint16_t topic_id, void *user) {
+    (void)payload; (void)payloadlen; (void)topic_id; (void)user;
+    unsigned char pingresp[] = {0x02, 0x17};
+    mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(),
+                          pingresp, sizeof(pingresp));
+}
+
+static void on_pingresp(const uint8_t *payload, int payloadlen,
+                        uint16_t topic_id, void *user) {
+    (void)payload; (void)payloadlen; (void)topic_id; (void)user;
+    mqttsn_gateway_on_pingresp();
+}
+
+static void on_disconnect(const uint8_t *payload, int payloadlen,
+                          uint16_t topic_id, void *user) {
+    (void)payload; (void)payloadlen; (void)topic_id; (void)user;
+    printf("[SUBSCRIBER] ✗ Received DISCONNECT from gateway (keepalive timeout?)\n");
+    mqtt_subscriber_ready = false;
+    mqttsn_demo_close();
 }
 
 // Subscribe to a topic
@@ -142,7 +130,7 @@ static int subscribe_to_topic(const char *topic_name) {
     }
     
     printf("[SUBSCRIBER] Sending SUBSCRIBE to '%s' with QoS 2...\n", topic_name);
-    int s = mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, buf, len);
+    int s = mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(), buf, len);
     if (s != 0) {
         printf("[SUBSCRIBER] SUBSCRIBE send failed\n");
         return -2;
@@ -178,11 +166,50 @@ static int subscribe_to_topic(const char *topic_name) {
     #endif
 }
 
+// SD card, block transfer state and the core-1 pipeline are initialised
+// exactly once. Session rebuilds (Wi-Fi drop, gateway DISCONNECT, gateway
+// failover) re-run the connect/subscribe path, but must not re-program the
+// shared SPI bus or reset receiver state while the core-1 worker may be
+// mid-f_write - once block_pipeline_start() has run, that state belongs
+// to core 1 (see block_pipeline.c).
+static void subscriber_init_storage_once(void) {
+    static bool initialised = false;
+
+    if (initialised) {
+        return;
+    }
+
+    // Collect the SD init that has been running on core 1 since boot;
+    // this also frees core 1 for the pipeline. On failure, try once
+    // more synchronously.
+    if (startup_sd_join(8000) == 0) {
+        printf("[SUBSCRIBER] ✓ SD card mounted and ready\n");
+    } else if (sd_card_init_with_detection() == 0 &&
+               sd_card_mount_fat32() == 0) {
+        printf("[SUBSCRIBER] ✓ SD card mounted and ready (retry)\n");
+    } else {
+        printf("[SUBSCRIBER] ⚠️  SD card unavailable (blocks won't be saved)\n");
+    }
+
+    // Initialize block transfer system
+    block_transfer_init();
+
+    // Move SD writes and reassembly to core 1 so chunk bursts keep
+    // flowing while the card is busy
+    block_pipeline_start();
+
+    initialised = true;
+}
+
 int main() {
     stdio_init_all();
-    sleep_ms(3000);
-    
+
     printf("\n=== MQTT-SN Pico W Subscriber Starting ===\n");
+
+    // SD init runs on core 1 while core 0 associates and talks to the
+    // gateway; it is joined (and core 1 freed for the block pipeline)
+    // just before the pipeline starts
+    startup_begin();
     
     // Setup LED
     gpio_init(LED_PIN);
@@ -197,10 +224,11 @@ int main() {
     
     if (wifi_connect() != 0) {
         printf("[WARNING] Initial connection failed - will retry\n");
+    } else {
+        startup_mark("Wi-Fi associated");
     }
-    
-    sleep_ms(2000);
-    
+
+
     // Main loop
     bool was_connected = false;
     uint32_t last_keepalive = 0;
@@ -234,22 +262,10 @@ int main() {
                 if (mqttsn_demo_init(0, "pico_w_subscriber") == 0) {
                     printf("[SUBSCRIBER] ✓ Connected to gateway\n");
                     
-                    // Initialize SD card for saving received blocks
-                    printf("[SUBSCRIBER] Initializing SD card...\n");
-                    if (sd_card_init_with_detection() == 0) {
-                        printf("[SUBSCRIBER] ✓ SD card hardware initialized\n");
-                        if (sd_card_mount_fat32() == 0) {
-                            printf("[SUBSCRIBER] ✓ SD card mounted and ready\n");
-                        } else {
-                            printf("[SUBSCRIBER] ⚠️  SD card mount failed (blocks won't be saved)\n");
-                        }
-                    } else {
-                        printf("[SUBSCRIBER] ⚠️  SD card not detected (blocks won't be saved)\n");
-                    }
-                    
-                    // Initialize block transfer system
-                    block_transfer_init();
-                    
+                    // Storage and the core-1 pipeline survive session
+                    // rebuilds; only the connection state is rebuilt here
+                    subscriber_init_storage_once();
+
                     // Subscribe to pico/test (for regular messages)
                     bool test_ok = (subscribe_to_topic("pico/test") == 0);
                     
@@ -269,7 +285,7 @@ int main() {
                     int len = MQTTSNSerialize_subscribe(buf, sizeof(buf), 0, 1, msgid, &topic);
                     
                     if (len > 0) {
-                        int s = mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, buf, len);
+                        int s = mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(), buf, len);
                         if (s == 0) {
                             int r = mqttsn_transport_receive(buf, sizeof(buf), 5000);
                             if (r > 0) {
@@ -288,7 +304,16 @@ int main() {
                     #endif
                     
                     if (test_ok && chunks_ok) {
+                        // One registration per consumer; routing a packet
+                        // is one table lookup from here on
+                        mqttsn_dispatch_reset();
+                        mqttsn_dispatch_register(0x0C, chunks_topicid, on_chunk_publish, NULL);
+                        mqttsn_dispatch_register(0x0C, MQTTSN_DISPATCH_ANY_TOPIC, on_default_publish, NULL);
+                        mqttsn_dispatch_register(0x16, 0, on_pingreq, NULL);
+                        mqttsn_dispatch_register(0x17, 0, on_pingresp, NULL);
+                        mqttsn_dispatch_register(0x18, 0, on_disconnect, NULL);
                         mqtt_subscriber_ready = true;
+                        startup_mark("Ready to receive");
                         printf("\n[READY] Listening for messages and blocks...\n\n");
                     } else {
                         printf("[SUBSCRIBER] Subscription failed, retrying...\n");
@@ -301,24 +326,42 @@ int main() {
                 }
             } else {
                 uint32_t now = to_ms_since_boot(get_absolute_time());
-                
+
+                // Gateway health: probe RTTs and rebuild the session if
+                // the prober failed over to another gateway
+                mqttsn_gateway_tick();
+                if (mqttsn_gateway_take_changed()) {
+                    printf("[SUBSCRIBER] Gateway changed - re-establishing session...\n");
+                    mqtt_subscriber_ready = false;
+                    mqttsn_demo_close();
+                    continue;
+                }
+
                 // Send keepalive PINGREQ every 30 seconds
                 if (now - last_keepalive > 30000) {
                     unsigned char pingreq[] = {0x02, 0x16};
-                    mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, 
+                    mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(), 
                                          pingreq, sizeof(pingreq));
                     last_keepalive = now;
                 }
                 
                 // Check for block transfer timeout and print status every 10 seconds
                 if (now - last_status_check > 10000) {
-                    block_transfer_check_timeout();
-                    
+                    // With the pipeline running, core 1 owns the timeout
+                    // check (it frees receiver state, which must not race
+                    // with chunk processing)
+                    if (!block_pipeline_active()) {
+                        block_transfer_check_timeout();
+                    }
+
                     // Print status if transfer is active
                     if (block_transfer_is_active()) {
                         block_transfer_print_status();
                     }
-                    
+
+                    // Stats snapshot for the dashboard (chunks/s, drops, heap)
+                    perf_counters_publish();
+
                     last_status_check = now;
                 }
                 
@@ -341,32 +384,43 @@ int main() {
                     }
                 }
                 
-                // Listen for incoming messages
-                unsigned char buf[512];
-                int rc = mqttsn_transport_receive(buf, sizeof(buf), 100);
-                
-                if (rc > 0) {
-                    uint8_t msg_type = buf[1];
-                    
-                    if (msg_type == 0x0C) {  // PUBLISH
-                        process_publish_message(buf, rc);
-                    } else if (msg_type == 0x16) {  // PINGREQ
-                        printf("[SUBSCRIBER] Received PINGREQ - sending PINGRESP\n");
-                        unsigned char pingresp[] = {0x02, 0x17};
-                        mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, 
-                                             pingresp, sizeof(pingresp));
-                    } else if (msg_type == 0x17) {  // PINGRESP
-                        // Received response to our PINGREQ - connection alive
-                    } else if (msg_type == 0x18) {  // DISCONNECT
-                        printf("[SUBSCRIBER] ✗ Received DISCONNECT from gateway (keepalive timeout?)\n");
-                        mqtt_subscriber_ready = false;
-                        mqttsn_demo_close();
-                    }
+                // Drain every queued message before blocking again. The
+                // dispatcher routes each packet to its registered handler;
+                // anything unclaimed (e.g. PINGRESP) needs no action.
+                unsigned char buf[MQTTSN_MAX_PACKET];
+                int rc;
+                while (mqtt_subscriber_ready &&
+                       (rc = mqttsn_transport_receive(buf, sizeof(buf), 0)) > 0) {
+                    mqttsn_dispatch_packet(buf, rc);
                 }
             }
         }
-        
-        sleep_ms(10);
+
+        // Block until a packet arrives or the nearest timer deadline
+        // (keepalive, timeout/status check, NACK timer) instead of the old
+        // fixed 10ms poll-sleep - chunks are processed the moment they land
+        uint32_t wait_ms = 1000;  // Upper bound: WiFi reconnect housekeeping
+        if (is_connected && mqtt_subscriber_ready) {
+            uint32_t now = to_ms_since_boot(get_absolute_time());
+            uint32_t elapsed, until;
+
+            elapsed = now - last_keepalive;
+            until = (elapsed < 30000) ? 30000 - elapsed : 0;
+            if (until < wait_ms) wait_ms = until;
+
+            elapsed = now - last_status_check;
+            until = (elapsed < 10000) ? 10000 - elapsed : 0;
+            if (until < wait_ms) wait_ms = until;
+
+            if (block_transfer_is_active()) {
+                elapsed = now - last_retx_request;
+                until = (elapsed < 2000) ? 2000 - elapsed : 0;
+                if (until < wait_ms) wait_ms = until;
+            }
+        }
+        if (wait_ms > 0) {
+            wifi_udp_wait_event(wait_ms);
+        }
     }
     
     mqttsn_demo_close();
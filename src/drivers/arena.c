@@ -0,0 +1,44 @@
+// arena.c - Static bump allocator for transfer-path buffers
+//
+// One statically reserved block, one cursor. alloc() bumps the cursor,
+// reset() rewinds it to zero; there is no per-region free and therefore
+// no fragmentation. The high-water mark survives resets so the stats
+// line shows the worst case the node has actually hit.
+
+#include <stdio.h>
+#include <stdint.h>
+#include "drivers/arena.h"
+
+static uint8_t arena_mem[ARENA_SIZE] __attribute__((aligned(4)));
+static size_t arena_cursor = 0;
+static size_t arena_hwm = 0;
+
+void *arena_alloc(size_t size) {
+    // Keep every region 4-byte aligned for struct overlays
+    size_t aligned = (size + 3u) & ~(size_t)3u;
+
+    if (aligned > ARENA_SIZE - arena_cursor) {
+        printf("[ARENA] ✗ Exhausted: %zu requested, %zu free (hwm=%zu)\n",
+               size, ARENA_SIZE - arena_cursor, arena_hwm);
+        return NULL;
+    }
+
+    void *region = &arena_mem[arena_cursor];
+    arena_cursor += aligned;
+    if (arena_cursor > arena_hwm) {
+        arena_hwm = arena_cursor;
+    }
+    return region;
+}
+
+void arena_reset(void) {
+    arena_cursor = 0;
+}
+
+size_t arena_used(void) {
+    return arena_cursor;
+}
+
+size_t arena_high_water(void) {
+    return arena_hwm;
+}
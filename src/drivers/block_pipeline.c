@@ -0,0 +1,115 @@
+// block_pipeline.c - Dual-core block transfer pipeline
+// Core 0 enqueues raw chunk packets as they arrive; core 1 dequeues them and
+// runs parsing, reassembly bookkeeping and the SD writes. The queue is a
+// single-producer single-consumer ring: core 0 only writes the tail index,
+// core 1 only writes the head index, so no locks are needed.
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "drivers/block_pipeline.h"
+#include "drivers/block_transfer.h"
+
+#define PIPELINE_QUEUE_DEPTH 8
+#define PIPELINE_SLOT_BYTES (sizeof(block_header_t) + BLOCK_CHUNK_SIZE_MAX)
+
+typedef struct {
+    uint16_t len;
+    uint8_t data[PIPELINE_SLOT_BYTES];
+} pipeline_slot_t;
+
+static pipeline_slot_t queue[PIPELINE_QUEUE_DEPTH];
+static volatile uint8_t queue_head = 0;  // Written by core 1 only
+static volatile uint8_t queue_tail = 0;  // Written by core 0 only
+static volatile bool worker_running = false;
+static uint32_t dropped_count = 0;
+
+static inline uint8_t queue_next(uint8_t idx) {
+    return (uint8_t)((idx + 1) % PIPELINE_QUEUE_DEPTH);
+}
+
+// Core 1 entry: drain the queue into the block transfer receiver, then run
+// the timeout check. The receiver (and therefore all FatFs/SPI traffic) is
+// only ever touched from this core while the pipeline is active.
+static void pipeline_core1_entry(void) {
+    printf("[PIPELINE] Core 1 worker started\n");
+    worker_running = true;
+
+    uint32_t last_timeout_check = to_ms_since_boot(get_absolute_time());
+
+    while (true) {
+        bool did_work = false;
+
+        while (queue_head != queue_tail) {
+            pipeline_slot_t *slot = &queue[queue_head];
+            process_block_chunk(slot->data, slot->len);
+            queue_head = queue_next(queue_head);
+            did_work = true;
+        }
+
+        // Timeout handling lives here too, so receiver state is never
+        // freed underneath a chunk being processed
+        uint32_t now = to_ms_since_boot(get_absolute_time());
+        if (now - last_timeout_check > 10000) {
+            block_transfer_check_timeout();
+            last_timeout_check = now;
+        }
+
+        if (!did_work) {
+            sleep_ms(1);
+        }
+    }
+}
+
+int block_pipeline_start(void) {
+    if (worker_running) {
+        return 0;
+    }
+
+    multicore_launch_core1(pipeline_core1_entry);
+
+    // Wait briefly for the worker to come up
+    uint32_t start = to_ms_since_boot(get_absolute_time());
+    while (!worker_running && (to_ms_since_boot(get_absolute_time()) - start) < 1000) {
+        sleep_ms(1);
+    }
+
+    if (!worker_running) {
+        printf("[PIPELINE] ✗ Core 1 worker did not start\n");
+        return -1;
+    }
+
+    printf("[PIPELINE] ✓ SD/reassembly moved to core 1\n");
+    return 0;
+}
+
+bool block_pipeline_active(void) {
+    return worker_running;
+}
+
+int block_pipeline_submit_chunk(const uint8_t *data, size_t len) {
+    if (data == NULL || len == 0 || len > PIPELINE_SLOT_BYTES) {
+        return -1;
+    }
+
+    uint8_t next_tail = queue_next(queue_tail);
+    if (next_tail == queue_head) {
+        // Queue full: drop and let the NACK path re-request the chunk
+        dropped_count++;
+        return -1;
+    }
+
+    pipeline_slot_t *slot = &queue[queue_tail];
+    memcpy(slot->data, data, len);
+    slot->len = (uint16_t)len;
+
+    // Publish the slot: tail update must come after the copy
+    __dmb();
+    queue_tail = next_tail;
+    return 0;
+}
+
+uint32_t block_pipeline_dropped(void) {
+    return dropped_count;
+}
@@ -6,9 +6,15 @@
 #include <string.h>
 #include <stdlib.h>
 #include "pico/stdlib.h"
+#include "drivers/arena.h"
 #include "drivers/block_transfer.h"
+#include "drivers/crc32.h"
+#include "drivers/lzss.h"
+#include "drivers/perf_counters.h"
 #include "drivers/sd_card.h"
 #include "protocol/mqttsn/mqttsn_adapter.h"
+#include "protocol/mqttsn/mqttsn_client.h"
+#include "ff.h"
 
 // External MQTT-SN functions
 extern int mqttsn_demo_publish_name(const char *topicname, const uint8_t *payload, int payloadlen);
@@ -20,35 +26,463 @@ extern int mqttsn_check_incoming_messages(void);  // Process NACK during send
 // SENDER STATE
 // ============================================================================
 
+// Streaming read window: how much file data is buffered at a time while
+// chunks from earlier windows are on the wire. Keeps sender heap use at a
+// few KB instead of holding the whole file. Fixed byte budget - the number
+// of chunks per window varies with the negotiated chunk size.
+#define SENDER_WINDOW_BYTES 4096
+
+// Fast-seek cluster link map size (per open transfer file). Files we
+// pre-allocate with f_expand are one fragment, so this only needs to be
+// big enough for the odd fragmented sender-side file; if a map does not
+// fit we just fall back to FatFs' normal FAT chain walk.
+#define BLOCK_CLMT_ENTRIES 16
+
 static struct {
     uint16_t block_id;
-    uint8_t *data;
+    uint8_t *data;           // RAM-backed transfers (send_block_transfer)
     size_t data_len;
     uint16_t total_chunks;
+    uint16_t chunk_size;     // Negotiated per transfer (MTU probe)
     bool active;
+    char filename[64];       // File-backed transfers stream from SD
+    FIL file;
+    bool file_open;
+    DWORD clmt[BLOCK_CLMT_ENTRIES];  // Fast-seek map for retransmit seeks
 } sender = {0};
 
 // ============================================================================
-// RECEIVER STATE
+// DELTA BASELINE (SENDER)
 // ============================================================================
 
+// Per-chunk CRCs of the last file this node fully sent. A delta send
+// compares the new file against these and only transmits chunks that
+// changed; consecutive captures of a mostly-static scene share most of
+// their chunks, so this cuts airtime by the shared fraction.
 static struct {
+    uint16_t block_id;       // Transfer the receiver knows these chunks from
+    uint16_t total_chunks;
+    uint16_t chunk_size;     // CRC granularity; deltas need a matching size
+    bool valid;
+    uint32_t chunk_crc[BLOCK_MAX_CHUNKS];
+} baseline;
+
+// Per-chunk CRCs of the send in progress; committed to the baseline only
+// when the whole transfer succeeds
+static uint32_t pending_crc[BLOCK_MAX_CHUNKS];
+
+static bool delta_requested = false;  // Set for the duration of a delta send
+
+// ============================================================================
+// RECEIVER STATE
+// ============================================================================
+
+// One reassembly context per concurrent sender. With several publisher Picos
+// on the same chunks topic, interleaved transfers each get their own context
+// (bitmap + output file) instead of destroying each other; when all slots are
+// busy the least-recently-updated transfer is evicted.
+#define BLOCK_RX_CONTEXTS 4
+
+typedef struct {
     uint16_t block_id;
     uint16_t total_chunks;
+    uint16_t chunk_size;     // From the chunk headers (negotiated per transfer)
     uint16_t received_count;
     uint16_t highest_chunk_received;  // Highest chunk number seen (tracks send progress)
-    bool *chunk_mask;        // Track which chunks received
-    uint8_t *buffer;         // Reassembly buffer
-    uint32_t buffer_size;
+    uint16_t last_chunk_len;  // data_len of the final chunk (for total size)
+    uint32_t chunk_bitmap[BLOCK_BITMAP_WORDS];  // One bit per chunk received
+    FIL file;                // Chunks are written straight to SD as they arrive
+    bool file_open;
+    DWORD clmt[BLOCK_CLMT_ENTRIES];  // Fast-seek map (O(1) out-of-order f_lseek)
+    char temp_name[32];      // In-progress filename, renamed on completion
+    uint8_t magic[4];        // First bytes of chunk 1, for file type detection
+    bool magic_valid;
+    uint32_t file_crc;       // Whole-file CRC-32 from the control message
+    bool file_crc_valid;
     bool active;
-    uint32_t last_update;    // Timestamp of last chunk
-} receiver = {0};
+    uint32_t last_update;    // Timestamp of last chunk (also the LRU key)
+} block_rx_ctx_t;
+
+static block_rx_ctx_t rx_table[BLOCK_RX_CONTEXTS];
+
+// Last completed transfer, kept so a file-CRC control message arriving
+// after the final chunk (the common, loss-free case) can still be checked,
+// and so a delta transfer can splice unchanged chunks from the saved file
+static struct {
+    uint16_t block_id;
+    char filename[64];
+    size_t size;
+    bool pending;            // Awaiting the file-CRC control message
+    bool valid;              // File exists on SD and passed/skipped CRC check
+} rx_done;
+
+// Chunk bitmap accessors (idx is 0-based)
+static inline bool chunk_bit_test(const block_rx_ctx_t *ctx, uint16_t idx) {
+    return (ctx->chunk_bitmap[idx >> 5] >> (idx & 31)) & 1u;
+}
+
+static inline void chunk_bit_set(block_rx_ctx_t *ctx, uint16_t idx) {
+    ctx->chunk_bitmap[idx >> 5] |= (1u << (idx & 31));
+}
+
+// Close and delete a partially written transfer file
+static void receiver_discard_file(block_rx_ctx_t *ctx) {
+    if (ctx->file_open) {
+        f_close(&ctx->file);
+        ctx->file_open = false;
+        f_unlink(ctx->temp_name);
+    }
+}
+
+// Re-read a saved file from SD and check its CRC-32 against the sender's.
+// Reading back what actually landed on the card catches SPI/SD corruption
+// that a checksum over the RAM buffer would miss. On mismatch the file is
+// deleted - a broken JPEG is worse than a missing one.
+static bool rx_verify_file_crc(const char *filename, size_t size, uint32_t expected) {
+    FIL f;
+    if (f_open(&f, filename, FA_READ) != FR_OK) {
+        printf("[RECEIVER] ✗ Cannot reopen '%s' for CRC check\n", filename);
+        return false;
+    }
+
+    uint8_t buf[512];
+    uint32_t state = CRC32_INIT;
+    size_t remaining = size;
+    while (remaining > 0) {
+        UINT to_read = (remaining < sizeof(buf)) ? remaining : sizeof(buf);
+        UINT bytes_read = 0;
+        if (f_read(&f, buf, to_read, &bytes_read) != FR_OK || bytes_read != to_read) {
+            f_close(&f);
+            printf("[RECEIVER] ✗ Read error during CRC check of '%s'\n", filename);
+            return false;
+        }
+        state = crc32_update(state, buf, bytes_read);
+        remaining -= bytes_read;
+    }
+    f_close(&f);
+
+    uint32_t actual = crc32_finalize(state);
+    if (actual != expected) {
+        printf("[RECEIVER] ✗ File CRC mismatch on '%s': got %08lX, expected %08lX - deleting\n",
+               filename, actual, expected);
+        f_unlink(filename);
+        return false;
+    }
+
+    printf("[RECEIVER] ✓ File CRC verified: %s (%08lX)\n", filename, actual);
+    return true;
+}
+
+// Context for an in-flight block_id, or NULL if none
+static block_rx_ctx_t *rx_find(uint16_t block_id) {
+    for (int i = 0; i < BLOCK_RX_CONTEXTS; i++) {
+        if (rx_table[i].active && rx_table[i].block_id == block_id) {
+            return &rx_table[i];
+        }
+    }
+    return NULL;
+}
+
+// Slot for a new transfer: a free context if there is one, otherwise the
+// least-recently-updated transfer is discarded and its slot reused.
+static block_rx_ctx_t *rx_acquire_slot(void) {
+    block_rx_ctx_t *lru = &rx_table[0];
+
+    for (int i = 0; i < BLOCK_RX_CONTEXTS; i++) {
+        if (!rx_table[i].active) {
+            return &rx_table[i];
+        }
+        if (rx_table[i].last_update < lru->last_update) {
+            lru = &rx_table[i];
+        }
+    }
+
+    printf("[RECEIVER] ⚠️  All %d contexts busy, evicting stalled BlockID=%u (%u/%u chunks)\n",
+           BLOCK_RX_CONTEXTS, lru->block_id, lru->received_count, lru->total_chunks);
+    receiver_discard_file(lru);
+    lru->active = false;
+    return lru;
+}
+
+// Initialize a context for a new transfer (fresh bitmap + output file).
+// Returns NULL if the output file cannot be opened.
+static block_rx_ctx_t *rx_start_transfer(uint16_t block_id, uint16_t total_parts,
+                                         uint16_t chunk_size) {
+    block_rx_ctx_t *ctx = rx_acquire_slot();
+    printf("[RECEIVER] New transfer: BlockID=%u, TotalChunks=%u, ChunkSize=%u\n",
+           block_id, total_parts, chunk_size);
+
+    // Initialize context (bitmap is static - no per-transfer allocation)
+    ctx->block_id = block_id;
+    ctx->total_chunks = total_parts;
+    ctx->chunk_size = chunk_size;
+    ctx->received_count = 0;
+    ctx->highest_chunk_received = 0;
+    ctx->last_chunk_len = 0;
+    ctx->magic_valid = false;
+    ctx->file_crc_valid = false;
+    memset(ctx->chunk_bitmap, 0, sizeof(ctx->chunk_bitmap));
+
+    // Open the output file; chunks are written at their known offset as
+    // they arrive, so out-of-order arrival needs no reassembly buffer
+    snprintf(ctx->temp_name, sizeof(ctx->temp_name), "block_%u.tmp", block_id);
+    FRESULT res = f_open(&ctx->file, ctx->temp_name, FA_CREATE_ALWAYS | FA_WRITE);
+    if (res != FR_OK) {
+        printf("[RECEIVER] ✗ Failed to open '%s' on SD (err=%d)\n", ctx->temp_name, res);
+        ctx->active = false;
+        return NULL;
+    }
+    ctx->file_open = true;
+
+    // The final size is bounded by the header's total_parts: pre-allocate
+    // it contiguously so writes never stall on per-cluster FAT updates,
+    // then build the fast-seek map so out-of-order chunk placement is an
+    // O(1) seek instead of a FAT chain walk. Both are best-effort - a full
+    // or fragmented card just falls back to the normal slow path.
+    if (f_expand(&ctx->file, (FSIZE_t)total_parts * chunk_size, 1) == FR_OK) {
+        ctx->clmt[0] = BLOCK_CLMT_ENTRIES;
+        ctx->file.cltbl = ctx->clmt;
+        if (f_lseek(&ctx->file, CREATE_LINKMAP) != FR_OK) {
+            ctx->file.cltbl = NULL;
+        }
+    }
+    printf("[RECEIVER] ✓ Writing chunks to '%s' as they arrive\n", ctx->temp_name);
+
+    ctx->active = true;
+    ctx->last_update = to_ms_since_boot(get_absolute_time());
+    return ctx;
+}
+
+// Truncate, rename and verify a fully reassembled transfer, and record it
+// as the last completed transfer (the pending-CRC record and delta base)
+static void rx_finalize(block_rx_ctx_t *ctx) {
+    printf("\n========================================\n");
+    printf("[SUCCESS] Transfer complete: %u chunks\n", ctx->total_chunks);
+
+    // Calculate actual data size (last chunk may be partial)
+    size_t total_size = ((size_t)(ctx->total_chunks - 1) * ctx->chunk_size)
+                        + ctx->last_chunk_len;
+
+    // The file was written incrementally; just truncate to the exact
+    // size and give it a proper name. Detach the fast-seek map first -
+    // fast-seek files cannot change size.
+    ctx->file.cltbl = NULL;
+    f_lseek(&ctx->file, total_size);
+    f_truncate(&ctx->file);
+    f_close(&ctx->file);
+    ctx->file_open = false;
+
+    // Detect file type from the magic bytes of chunk 1
+    const char *extension = ".bin";
+    if (ctx->magic_valid) {
+        if (ctx->magic[0] == 0xFF && ctx->magic[1] == 0xD8 && ctx->magic[2] == 0xFF) {
+            extension = ".jpg";
+        } else if (ctx->magic[0] == 0x89 && ctx->magic[1] == 0x50 &&
+                   ctx->magic[2] == 0x4E && ctx->magic[3] == 0x47) {
+            extension = ".png";
+        } else if (ctx->magic[0] == 0x47 && ctx->magic[1] == 0x49 &&
+                   ctx->magic[2] == 0x46) {
+            extension = ".gif";
+        }
+    }
+
+    // Generate filename
+    char filename[64];
+    snprintf(filename, sizeof(filename), "block_%u%s", ctx->block_id, extension);
+
+    f_unlink(filename);  // Replace any previous file of the same name
+    FRESULT rc = f_rename(ctx->temp_name, filename);
+    if (rc == FR_OK) {
+        printf("[SD CARD] Saved: %s (%zu bytes)\n", filename, total_size);
+
+        // Record as the last completed transfer: the delta base for the
+        // next transfer, and the target of a late file-CRC check
+        rx_done.block_id = ctx->block_id;
+        strncpy(rx_done.filename, filename, sizeof(rx_done.filename) - 1);
+        rx_done.filename[sizeof(rx_done.filename) - 1] = '\0';
+        rx_done.size = total_size;
+
+        // Verify against the sender's whole-file CRC if we have it;
+        // otherwise the control message (usually sent right after the
+        // last chunk) triggers the check via the record above
+        if (ctx->file_crc_valid) {
+            rx_done.valid = rx_verify_file_crc(filename, total_size, ctx->file_crc);
+            rx_done.pending = false;
+        } else {
+            rx_done.valid = true;
+            rx_done.pending = true;
+        }
+        printf("========================================\n\n");
+    } else {
+        printf("[ERROR] SD card rename failed (err=%d)\n", rc);
+        printf("========================================\n\n");
+    }
+
+    // Clean up
+    ctx->active = false;
+}
+
+// Splice the unchanged chunks of a delta transfer from the saved base
+// file. Anything that cannot be spliced (base file gone, short read) is
+// simply left unmarked and recovered through the normal SACK path.
+static void rx_handle_delta_announce(uint16_t block_id, uint16_t total_parts,
+                                     uint16_t chunk_size,
+                                     const uint8_t *payload, uint16_t data_len) {
+    block_delta_header_t delta;
+    memcpy(&delta, payload, sizeof(delta));
+
+    uint16_t words = (total_parts + 31) / 32;
+    if (total_parts == 0 || total_parts > BLOCK_MAX_CHUNKS ||
+        data_len < sizeof(block_delta_header_t) + (size_t)words * 4) {
+        printf("[RECEIVER] ✗ Invalid delta announce (total=%u, len=%u)\n",
+               total_parts, data_len);
+        return;
+    }
+
+    block_rx_ctx_t *ctx = rx_find(block_id);
+    if (ctx == NULL) {
+        ctx = rx_start_transfer(block_id, total_parts, chunk_size);
+        if (ctx == NULL) {
+            return;
+        }
+    }
+
+    if (!rx_done.valid || rx_done.block_id != delta.base_block_id) {
+        // Base file is gone: pretend the skipped chunks were sent and
+        // lost, so the SACK covers the full range and the sender
+        // retransmits them from the new file
+        printf("[RECEIVER] ⚠️  Delta base BlockID=%u not available, will NACK everything\n",
+               delta.base_block_id);
+        ctx->highest_chunk_received = total_parts;
+        return;
+    }
+
+    FIL base;
+    if (f_open(&base, rx_done.filename, FA_READ) != FR_OK) {
+        printf("[RECEIVER] ✗ Cannot open base file '%s'\n", rx_done.filename);
+        ctx->highest_chunk_received = total_parts;
+        return;
+    }
+
+    const uint8_t *bitmap = payload + sizeof(block_delta_header_t);
+    static uint8_t chunk_buf[BLOCK_CHUNK_SIZE_MAX];
+    uint16_t spliced = 0;
+
+    for (uint16_t i = 0; i < total_parts; i++) {
+        uint32_t word;
+        memcpy(&word, bitmap + (i >> 5) * 4, 4);  // Unaligned-safe
+        if (!(word & (1u << (i & 31)))) continue;
+        if (chunk_bit_test(ctx, i)) continue;
+
+        size_t offset = (size_t)i * ctx->chunk_size;
+        if (offset >= rx_done.size) break;
+        size_t chunk_len = rx_done.size - offset;
+        if (chunk_len > ctx->chunk_size) chunk_len = ctx->chunk_size;
+
+        UINT bytes_read = 0, bytes_written = 0;
+        if (f_lseek(&base, offset) != FR_OK ||
+            f_read(&base, chunk_buf, chunk_len, &bytes_read) != FR_OK ||
+            bytes_read != chunk_len) {
+            continue;
+        }
+        if (f_lseek(&ctx->file, offset) != FR_OK ||
+            f_write(&ctx->file, chunk_buf, chunk_len, &bytes_written) != FR_OK ||
+            bytes_written != chunk_len) {
+            continue;
+        }
+
+        if (i == 0 && chunk_len >= 4) {
+            memcpy(ctx->magic, chunk_buf, 4);
+            ctx->magic_valid = true;
+        }
+        if (i == total_parts - 1) {
+            // Equal CRCs imply equal length, so the base chunk's length
+            // is also the new file's final chunk length
+            ctx->last_chunk_len = chunk_len;
+        }
+
+        chunk_bit_set(ctx, i);
+        ctx->received_count++;
+        spliced++;
+    }
+    f_close(&base);
+
+    ctx->last_update = to_ms_since_boot(get_absolute_time());
+    printf("[RECEIVER] ✓ Spliced %u/%u chunks from '%s' (base BlockID=%u)\n",
+           spliced, total_parts, rx_done.filename, delta.base_block_id);
+
+    // An all-unchanged delta completes right here
+    if (ctx->received_count == ctx->total_chunks) {
+        rx_finalize(ctx);
+    }
+}
+
+// Forward declarations (sender internals)
+static int sender_publish_chunk(const char *topic, uint8_t qos, uint16_t chunk_num,
+                                uint16_t total_chunks, const uint8_t *chunk_data,
+                                size_t chunk_data_len);
+static int send_file_stream_qos(const char *topic, size_t data_len, uint8_t qos);
+
+// ============================================================================
+// ADAPTIVE PACING (AIMD)
+// ============================================================================
+
+// Inter-chunk gap adjusted from delivery feedback instead of a fixed sleep:
+// every probe interval, shrink the gap by 1ms if nothing was lost (additive
+// increase) and double it on loss (multiplicative decrease). Loss is inferred
+// from window resends at QoS 1 and from NACK retransmission volume at QoS 0.
+#define PACING_GAP_INITIAL_MS 10    // Same as the old fixed sleep
+#define PACING_GAP_MAX_MS 80
+#define PACING_PROBE_CHUNKS 16      // Chunks between rate adjustments
+
+static struct {
+    uint32_t gap_ms;
+    uint32_t last_resends;          // mqttsn_publish_window_resends() snapshot
+    uint32_t last_retx;             // retx_total snapshot (QoS 0 NACK volume)
+    uint16_t chunks_since_probe;
+} pacing = {0};
+
+static uint32_t retx_total = 0;     // Chunks resent via the NACK path
+
+static void pacing_reset(void) {
+    pacing.gap_ms = PACING_GAP_INITIAL_MS;
+    pacing.last_resends = mqttsn_publish_window_resends();
+    pacing.last_retx = retx_total;
+    pacing.chunks_since_probe = 0;
+}
+
+// Called after each chunk: applies the current gap, and once per probe
+// interval adjusts it from the loss signal seen since the last probe.
+static void pacing_chunk_sent(void) {
+    if (++pacing.chunks_since_probe >= PACING_PROBE_CHUNKS) {
+        pacing.chunks_since_probe = 0;
+
+        uint32_t resends = mqttsn_publish_window_resends();
+        bool loss = (resends != pacing.last_resends) ||
+                    (retx_total != pacing.last_retx);
+        pacing.last_resends = resends;
+        pacing.last_retx = retx_total;
+
+        if (loss) {
+            pacing.gap_ms = (pacing.gap_ms == 0) ? 2 : pacing.gap_ms * 2;
+            if (pacing.gap_ms > PACING_GAP_MAX_MS) pacing.gap_ms = PACING_GAP_MAX_MS;
+            printf("[SENDER] Pacing: loss detected, gap -> %lums\n", pacing.gap_ms);
+        } else if (pacing.gap_ms > 0) {
+            pacing.gap_ms--;
+        }
+    }
+
+    if (pacing.gap_ms > 0) {
+        sleep_ms(pacing.gap_ms);
+    }
+}
 
 // ============================================================================
 // INITIALIZATION
 // ============================================================================
 
 int block_transfer_init(void) {
+    crc32_init();
     printf("[BLOCK] Block transfer system initialized\n");
     return 0;
 }
@@ -57,11 +491,19 @@ int block_transfer_init(void) {
 // SENDER: SEND IMAGE FILE FROM SD CARD WITH QoS
 // ============================================================================
 
+static void fetch_cache_invalidate(void);  // Defined with the cache below
+
 void block_transfer_reset_sender(void) {
     if (sender.data) {
-        free(sender.data);
-        sender.data = NULL;
+        sender.data = NULL;  // Arena region; reclaimed by the reset below
+        arena_reset();
+    }
+    if (sender.file_open) {
+        f_close(&sender.file);
+        sender.file_open = false;
     }
+    fetch_cache_invalidate();
+    sender.filename[0] = '\0';
     sender.active = false;
     sender.data_len = 0;
     sender.total_chunks = 0;
@@ -69,63 +511,224 @@ void block_transfer_reset_sender(void) {
     printf("[SENDER] ✓ Reset complete, ready for new transfer\n");
 }
 
+// ============================================================================
+// RETRANSMIT SECTOR CACHE
+// ============================================================================
+
+// Burst NACKs request runs of consecutive chunks, and several chunks share
+// each cache granule (the granule is a multiple of every negotiable chunk
+// size): caching the last few granules read turns a retransmit burst into
+// one SD read per granule instead of one per chunk.
+#define FETCH_CACHE_SECTOR_SIZE BLOCK_CHUNK_SIZE_MAX
+#define FETCH_CACHE_ENTRIES 4
+
+static struct {
+    size_t offset;          // File offset of the cached sector (aligned)
+    size_t len;             // Valid bytes (short at end of file)
+    uint32_t last_use;      // LRU stamp
+    bool valid;
+    uint8_t data[FETCH_CACHE_SECTOR_SIZE];
+} fetch_cache[FETCH_CACHE_ENTRIES];
+static uint32_t fetch_cache_clock = 0;
+
+static void fetch_cache_invalidate(void) {
+    for (int i = 0; i < FETCH_CACHE_ENTRIES; i++) {
+        fetch_cache[i].valid = false;
+    }
+    fetch_cache_clock = 0;
+}
+
+// Read len bytes at the given file offset through the sector cache.
+// Chunk sizes are powers of two dividing the granule, so a read never
+// straddles two cached granules.
+static int fetch_cached_read(size_t offset, uint8_t *out, size_t len) {
+    size_t sec_off = offset & ~(size_t)(FETCH_CACHE_SECTOR_SIZE - 1);
+
+    for (int i = 0; i < FETCH_CACHE_ENTRIES; i++) {
+        if (fetch_cache[i].valid && fetch_cache[i].offset == sec_off) {
+            if ((offset - sec_off) + len > fetch_cache[i].len) {
+                return -1;
+            }
+            memcpy(out, fetch_cache[i].data + (offset - sec_off), len);
+            fetch_cache[i].last_use = ++fetch_cache_clock;
+            return 0;
+        }
+    }
+
+    // Miss: evict the LRU entry (or take a free one) and fill it
+    int victim = 0;
+    for (int i = 1; i < FETCH_CACHE_ENTRIES; i++) {
+        if (!fetch_cache[i].valid) {
+            victim = i;
+            break;
+        }
+        if (fetch_cache[victim].valid &&
+            fetch_cache[i].last_use < fetch_cache[victim].last_use) {
+            victim = i;
+        }
+    }
+
+    size_t want = FETCH_CACHE_SECTOR_SIZE;
+    if (sec_off + want > sender.data_len) {
+        want = sender.data_len - sec_off;
+    }
+    UINT bytes_read = 0;
+    if (f_lseek(&sender.file, sec_off) != FR_OK ||
+        f_read(&sender.file, fetch_cache[victim].data, want, &bytes_read) != FR_OK ||
+        bytes_read != want) {
+        return -2;
+    }
+    fetch_cache[victim].offset = sec_off;
+    fetch_cache[victim].len = want;
+    fetch_cache[victim].valid = true;
+    fetch_cache[victim].last_use = ++fetch_cache_clock;
+
+    if ((offset - sec_off) + len > want) {
+        return -1;
+    }
+    memcpy(out, fetch_cache[victim].data + (offset - sec_off), len);
+    return 0;
+}
+
+// Fetch one chunk of the active transfer. RAM-backed transfers copy from the
+// in-memory buffer; file-backed transfers seek and read the SD file, so only
+// the current read window ever lives in RAM.
+static int sender_fetch_chunk(uint16_t chunk_num, uint8_t *out, size_t *out_len) {
+    size_t offset = (size_t)(chunk_num - 1) * sender.chunk_size;
+    if (offset >= sender.data_len) {
+        return -1;
+    }
+
+    size_t remaining = sender.data_len - offset;
+    size_t chunk_data_len = (remaining < sender.chunk_size) ? remaining : sender.chunk_size;
+
+    if (sender.data != NULL) {
+        memcpy(out, sender.data + offset, chunk_data_len);
+    } else if (sender.file_open) {
+        if (fetch_cached_read(offset, out, chunk_data_len) != 0) {
+            return -3;
+        }
+    } else {
+        return -4;
+    }
+
+    *out_len = chunk_data_len;
+    return 0;
+}
+
+// ============================================================================
+// CHUNK SIZE NEGOTIATION (PATH MTU PROBE)
+// ============================================================================
+
+// Probe the usable end-to-end payload size through the gateway: padded
+// QoS 1 probes from BLOCK_CHUNK_SIZE_MAX downward, halving until one is
+// acked. One acked probe proves header+payload of that size traverses
+// the gateway and broker, so the whole transfer can use it - 1KB chunks
+// cut the packet count (and per-chunk acks, sleeps and loss exposure)
+// 8x versus the 128-byte fallback.
+static uint16_t sender_probe_chunk_size(const char *topic) {
+    static uint8_t probe[sizeof(block_header_t) + BLOCK_CHUNK_SIZE_MAX];
+    uint16_t result = BLOCK_CHUNK_SIZE;
+
+    int prev_qos = mqttsn_get_qos();
+    mqttsn_set_qos(1);  // The PUBACK is the probe's success signal
+
+    for (uint16_t size = BLOCK_CHUNK_SIZE_MAX; size > BLOCK_CHUNK_SIZE; size /= 2) {
+        block_header_t *header = (block_header_t *)probe;
+        header->block_id = 0;
+        header->part_num = 0;
+        header->total_parts = 0;
+        header->data_len = size;
+        header->flags = 0;
+        header->chunk_size_64 = (uint8_t)(size / 64);
+        header->data_crc = 0;
+        memset(probe + sizeof(block_header_t), 0, size);
+        probe[sizeof(block_header_t)] = BLOCK_PROBE_MAGIC;
+
+        if (mqttsn_publish_window_send(topic, probe, sizeof(block_header_t) + size) == 0 &&
+            mqttsn_publish_window_flush(2000) == 0) {
+            result = size;
+            break;
+        }
+        printf("[SENDER] Probe at %u bytes not acked, trying smaller\n", size);
+    }
+
+    mqttsn_set_qos(prev_qos);
+    printf("[SENDER] ✓ Negotiated chunk size: %u bytes\n", result);
+    return result;
+}
+
 int send_image_file_qos(const char *topic, const char *filename, uint8_t qos) {
     if (sender.active) {
         printf("[SENDER] ✗ Another transfer in progress\n");
         return -1;
     }
-    
-    // Allocate buffer for file data
-    uint8_t *file_buffer = malloc(BLOCK_BUFFER_SIZE);
-    if (!file_buffer) {
-        printf("[SENDER] ✗ Failed to allocate buffer\n");
-        return -2;
-    }
-    
-    // Read file from SD card
-    size_t actual_size = 0;
-    int rc = sd_card_read_file(filename, file_buffer, BLOCK_BUFFER_SIZE, &actual_size);
-    if (rc != 0) {
-        printf("[SENDER] ✗ Failed to read file '%s' (err=%d)\n", filename, rc);
-        free(file_buffer);
+
+    // Open the file and stream it in windows: SD reads for later chunks
+    // overlap with transmission of earlier ones, so there is no whole-file
+    // buffer and no 58KB size ceiling.
+    FRESULT res = f_open(&sender.file, filename, FA_READ);
+    if (res != FR_OK) {
+        printf("[SENDER] ✗ Failed to open file '%s' (err=%d)\n", filename, res);
         return -3;
     }
-    
-    if (actual_size == 0 || actual_size > MAX_SUPPORTED_FILE_SIZE) {
-        printf("[SENDER] ✗ Invalid file size: %zu bytes\n", actual_size);
-        free(file_buffer);
+    sender.file_open = true;
+
+    // Fast-seek map: NACK retransmits seek all over the file, and window
+    // refills seek past skipped delta chunks
+    sender.clmt[0] = BLOCK_CLMT_ENTRIES;
+    sender.file.cltbl = sender.clmt;
+    if (f_lseek(&sender.file, CREATE_LINKMAP) != FR_OK) {
+        sender.file.cltbl = NULL;  // Too fragmented for the map; seek the slow way
+    }
+
+    fetch_cache_invalidate();  // Sectors cached from the previous file
+
+    size_t actual_size = f_size(&sender.file);
+    if (actual_size == 0 || actual_size > (size_t)BLOCK_MAX_CHUNKS * BLOCK_CHUNK_SIZE) {
+        printf("[SENDER] ✗ Invalid file size: %zu bytes (max %u chunks)\n",
+               actual_size, BLOCK_MAX_CHUNKS);
+        f_close(&sender.file);
+        sender.file_open = false;
         return -4;
     }
-    
-    printf("[SENDER] ✓ Read file '%s': %zu bytes\n", filename, actual_size);
-    
-    // This allows NACK retransmissions to work during the transfer
-    sender.data = file_buffer;
+
+    printf("[SENDER] ✓ Opened file '%s': %zu bytes (streaming)\n", filename, actual_size);
+
+    // File stays open for the whole transfer so NACK retransmissions can
+    // re-read any chunk straight from SD
+    strncpy(sender.filename, filename, sizeof(sender.filename) - 1);
+    sender.filename[sizeof(sender.filename) - 1] = '\0';
+    sender.data = NULL;
     sender.data_len = actual_size;
     sender.active = true;
     printf("[SENDER] ✓ Sender state activated, ready for transfer and retransmissions\n");
-    
+
+    // Negotiate the chunk size for this transfer (path MTU probe)
+    sender.chunk_size = sender_probe_chunk_size(topic);
+
     // Set QoS level
     int prev_qos = mqttsn_get_qos();
     mqttsn_set_qos(qos);
-    
-    // Send block transfer
-    int result = send_block_transfer_qos(topic, file_buffer, actual_size, qos);
-    
+
+    // Send block transfer, streaming from the open file
+    int result = send_file_stream_qos(topic, actual_size, qos);
+
     // Restore previous QoS
     mqttsn_set_qos(prev_qos);
-    
+
     // On failure, clean up sender state
     if (result != 0) {
         printf("[SENDER] ✗ Transfer failed, cleaning up\n");
-        free(file_buffer);
-        sender.data = NULL;
+        f_close(&sender.file);
+        sender.file_open = false;
+        sender.filename[0] = '\0';
         sender.data_len = 0;
         sender.active = false;
     } else {
-        printf("[SENDER] ✓ Transfer complete, keeping buffer for retransmissions\n");
+        printf("[SENDER] ✓ Transfer complete, keeping file open for retransmissions\n");
     }
-    
+
     return result;
 }
 
@@ -137,61 +740,352 @@ int send_image_file(const char *topic, const char *filename) {
 // SENDER: SEND BLOCK TRANSFER WITH QoS
 // ============================================================================
 
+// Build the header for one chunk and publish it, using the windowed engine
+// at QoS 1 so several chunks stay in flight at once.
+static int sender_publish_chunk(const char *topic, uint8_t qos, uint16_t chunk_num,
+                                uint16_t total_chunks, const uint8_t *chunk_data,
+                                size_t chunk_data_len) {
+    // Static: at the negotiated maximum these are too big for the stack,
+    // and the publish path runs on one core only
+    static uint8_t chunk_buffer[sizeof(block_header_t) + BLOCK_CHUNK_SIZE_MAX];
+    static uint8_t compressed[LZSS_MAX_COMPRESSED(BLOCK_CHUNK_SIZE_MAX)];
+
+    // Compress the chunk; keep the raw bytes when that does not help.
+    // Compressible payloads (JSON, BMP, logs) shrink well below the
+    // chunk budget, so the same radio time moves more file bytes.
+    const uint8_t *wire_data = chunk_data;
+    size_t wire_len = chunk_data_len;
+    uint8_t flags = 0;
+    size_t comp_len = lzss_compress(chunk_data, chunk_data_len,
+                                    compressed, sizeof(compressed));
+    if (comp_len > 0 && comp_len < chunk_data_len) {
+        wire_data = compressed;
+        wire_len = comp_len;
+        flags = BLOCK_FLAG_COMPRESSED;
+    }
+
+    // Build chunk header
+    block_header_t *header = (block_header_t *)chunk_buffer;
+    header->block_id = sender.block_id; // Which transfer
+    header->part_num = chunk_num;       // THIS IS CHUNK #Nnumber
+    header->total_parts = total_chunks; // Total chunks
+    header->data_len = wire_len;
+    header->flags = flags;
+    header->chunk_size_64 = (uint8_t)(sender.chunk_size / 64);
+    header->data_crc = crc32_buffer(wire_data, wire_len);  // DMA sniffer
+
+    // Copy chunk data
+    memcpy(chunk_buffer + sizeof(block_header_t), wire_data, wire_len);
+    size_t total_len = sizeof(block_header_t) + wire_len;
+
+    // Send via MQTT-SN with limited retries (let NACK handle failures)
+    int rc;
+    if (qos >= 1) {
+        rc = mqttsn_publish_window_send(topic, chunk_buffer, total_len);
+        while (rc == MQTTSN_EWINDOWFULL) {
+            // Window full: drain acks until a slot frees up
+            mqttsn_publish_window_poll(20);
+            rc = mqttsn_publish_window_send(topic, chunk_buffer, total_len);
+        }
+        // Opportunistically complete acks without blocking
+        mqttsn_publish_window_poll(0);
+    } else {
+        rc = mqttsn_demo_publish_name(topic, chunk_buffer, total_len);
+    }
+
+    int retry_count = 0;
+    while (rc != 0 && retry_count < 3) {
+        retry_count++;
+        printf("[SENDER] ⚠️  Chunk %u/%u failed (attempt %d/3), retrying...\n",
+               chunk_num, total_chunks, retry_count);
+        sleep_ms(50);
+        rc = (qos >= 1) ? mqttsn_publish_window_send(topic, chunk_buffer, total_len)
+                        : mqttsn_demo_publish_name(topic, chunk_buffer, total_len);
+    }
+
+    if (rc != 0) {
+        printf("[SENDER] ⚠️  Chunk %u/%u failed after 3 attempts, continuing (will be retransmitted via NACK)\n",
+               chunk_num, total_chunks);
+        // let NACK retransmission handle missing chunks
+    }
+
+    perf.chunks_sent++;
+    return rc;
+}
+
+// End-of-transfer control message: part_num 0, whole-file CRC in data_crc.
+// Sent QoS 0 - if it's lost the receiver just skips verification, and the
+// per-chunk CRCs have already covered the data itself.
+static void sender_send_file_crc(const char *topic, uint32_t file_crc) {
+    block_header_t header;
+    header.block_id = sender.block_id;
+    header.part_num = 0;
+    header.total_parts = sender.total_chunks;
+    header.data_len = 0;
+    header.flags = 0;
+    header.chunk_size_64 = (uint8_t)(sender.chunk_size / 64);
+    header.data_crc = file_crc;
+
+    int prev_qos = mqttsn_get_qos();
+    mqttsn_set_qos(0);
+    int rc = mqttsn_demo_publish_name(topic, (const uint8_t *)&header, sizeof(header));
+    mqttsn_set_qos(prev_qos);
+
+    if (rc == 0) {
+        printf("[SENDER] ✓ File CRC sent: %08lX\n", file_crc);
+    } else {
+        printf("[SENDER] ⚠️  Failed to send file CRC (err=%d)\n", rc);
+    }
+}
+
+// Delta announce: tells the receiver which chunks of the new transfer are
+// byte-identical to the baseline transfer and will not be sent. QoS 1 so
+// it reliably arrives before the chunks; if the receiver no longer has the
+// base file, the spliceless chunks come back through the SACK path.
+static void sender_send_delta_announce(const char *topic, uint16_t total_chunks,
+                                       const uint32_t *skip_bitmap, uint16_t skipped) {
+    uint8_t msg[sizeof(block_header_t) + sizeof(block_delta_header_t) + BLOCK_BITMAP_WORDS * 4];
+    uint16_t words = (total_chunks + 31) / 32;
+
+    block_header_t *header = (block_header_t *)msg;
+    header->block_id = sender.block_id;
+    header->part_num = 0;
+    header->total_parts = total_chunks;
+    header->data_len = sizeof(block_delta_header_t) + words * 4;
+    header->flags = 0;
+    header->chunk_size_64 = (uint8_t)(sender.chunk_size / 64);
+    header->data_crc = 0;
+
+    block_delta_header_t *delta = (block_delta_header_t *)(msg + sizeof(block_header_t));
+    delta->magic = BLOCK_DELTA_MAGIC;
+    delta->reserved = 0;
+    delta->base_block_id = baseline.block_id;
+    delta->base_total = baseline.total_chunks;
+
+    memcpy(msg + sizeof(block_header_t) + sizeof(block_delta_header_t),
+           skip_bitmap, (size_t)words * 4);
+
+    int prev_qos = mqttsn_get_qos();
+    mqttsn_set_qos(1);
+    int rc = mqttsn_demo_publish_name(topic, msg, sizeof(block_header_t) + header->data_len);
+    mqttsn_set_qos(prev_qos);
+
+    if (rc == 0) {
+        printf("[SENDER] ✓ Delta announce sent: %u/%u chunks unchanged vs BlockID=%u\n",
+               skipped, total_chunks, baseline.block_id);
+    } else {
+        printf("[SENDER] ⚠️  Delta announce failed (err=%d), receiver will NACK\n", rc);
+    }
+}
+
+// Stream the open sender file to the topic one read window at a time, so SD
+// I/O for later chunks overlaps with transmission of earlier ones.
+static int send_file_stream_qos(const char *topic, size_t data_len, uint8_t qos) {
+    if (!sender.file_open) {
+        printf("[SENDER] ✗ No open file to stream\n");
+        return -1;
+    }
+
+    // Calculate number of chunks at the negotiated size
+    uint16_t chunk_size = sender.chunk_size;
+    uint16_t total_chunks = (data_len + chunk_size - 1) / chunk_size;
+    uint16_t block_id = (uint16_t)(to_ms_since_boot(get_absolute_time()) & 0xFFFF);
+
+    printf("[SENDER] Starting streamed transfer: BlockID=%u, Size=%zu bytes, Chunks=%u x %u, QoS=%d\n",
+           block_id, data_len, total_chunks, chunk_size, qos);
+
+    // Store sender state for retransmissions
+    sender.block_id = block_id;
+    sender.total_chunks = total_chunks;
+
+    static uint8_t window[SENDER_WINDOW_BYTES];
+    uint32_t start_time = to_ms_since_boot(get_absolute_time());
+
+    // Pre-scan pass: one sequential read of the file computes the whole-file
+    // CRC and every per-chunk CRC (DMA sniffer, so this is SD-read bound).
+    // The per-chunk CRCs feed the delta comparison now and become the next
+    // baseline if the transfer succeeds.
+    uint32_t crc_state = CRC32_INIT;
+    for (size_t offset = 0; offset < data_len; offset += SENDER_WINDOW_BYTES) {
+        size_t to_read = data_len - offset;
+        if (to_read > SENDER_WINDOW_BYTES) to_read = SENDER_WINDOW_BYTES;
+
+        UINT bytes_read = 0;
+        FRESULT res = f_lseek(&sender.file, offset);
+        if (res == FR_OK) {
+            res = f_read(&sender.file, window, to_read, &bytes_read);
+        }
+        if (res != FR_OK || bytes_read != to_read) {
+            printf("[SENDER] ✗ SD read failed at offset %zu (err=%d)\n", offset, res);
+            return -2;
+        }
+
+        crc_state = crc32_update(crc_state, window, to_read);
+        for (size_t pos = 0; pos < to_read; pos += chunk_size) {
+            size_t chunk_len = to_read - pos;
+            if (chunk_len > chunk_size) chunk_len = chunk_size;
+            pending_crc[(offset + pos) / chunk_size] =
+                crc32_buffer(window + pos, chunk_len);
+        }
+    }
+    uint32_t file_crc = crc32_finalize(crc_state);
+
+    // Delta mode: mark chunks identical to the baseline and announce the
+    // reuse bitmap so the receiver splices them from its saved copy
+    static uint32_t skip_bitmap[BLOCK_BITMAP_WORDS];
+    memset(skip_bitmap, 0, sizeof(skip_bitmap));
+    uint16_t skipped = 0;
+
+    if (delta_requested && baseline.valid && baseline.chunk_size == chunk_size) {
+        uint16_t overlap = (total_chunks < baseline.total_chunks)
+                           ? total_chunks : baseline.total_chunks;
+        for (uint16_t i = 0; i < overlap; i++) {
+            if (pending_crc[i] == baseline.chunk_crc[i]) {
+                skip_bitmap[i >> 5] |= (1u << (i & 31));
+                skipped++;
+            }
+        }
+
+        if (skipped > 0) {
+            sender_send_delta_announce(topic, total_chunks, skip_bitmap, skipped);
+        }
+    } else if (delta_requested) {
+        printf("[SENDER] No baseline yet, sending full file\n");
+    }
+
+    pacing_reset();
+    size_t window_loaded = (size_t)-1;  // File offset of the loaded window
+
+    for (uint16_t chunk_num = 1; chunk_num <= total_chunks; chunk_num++) {
+        // Unchanged chunk: the receiver splices it from the base file
+        if (skip_bitmap[(chunk_num - 1) >> 5] & (1u << ((chunk_num - 1) & 31))) {
+            continue;
+        }
+
+        size_t offset = (size_t)(chunk_num - 1) * chunk_size;
+        size_t window_pos = offset % SENDER_WINDOW_BYTES;
+        size_t window_base = offset - window_pos;
+
+        // Refill the window when the chunk falls outside the loaded one.
+        // Always re-seek first: a NACK retransmission may have moved the
+        // file pointer.
+        if (window_base != window_loaded) {
+            size_t to_read = data_len - window_base;
+            if (to_read > SENDER_WINDOW_BYTES) to_read = SENDER_WINDOW_BYTES;
+
+            UINT bytes_read = 0;
+            FRESULT res = f_lseek(&sender.file, window_base);
+            if (res == FR_OK) {
+                res = f_read(&sender.file, window, to_read, &bytes_read);
+            }
+            if (res != FR_OK || bytes_read != to_read) {
+                printf("[SENDER] ✗ SD read failed at offset %zu (err=%d)\n", window_base, res);
+                return -2;
+            }
+            window_loaded = window_base;
+        }
+
+        size_t remaining = data_len - offset;
+        size_t chunk_data_len = (remaining < chunk_size) ? remaining : chunk_size;
+
+        sender_publish_chunk(topic, qos, chunk_num, total_chunks,
+                             window + window_pos, chunk_data_len);
+
+        // Progress indicator with ETA (at 25, 75, 125... to avoid collision with receiver at 50, 100, 150...)
+        if ((chunk_num % 50 == 25) || chunk_num == total_chunks) {
+            uint32_t elapsed = to_ms_since_boot(get_absolute_time()) - start_time;
+            float progress = (chunk_num * 100.0f) / total_chunks;
+            uint32_t eta = 0;
+            if (chunk_num > 0) {
+                eta = (elapsed * (total_chunks - chunk_num)) / chunk_num;
+            }
+            printf("[SENDER] %u/%u (%.1f%%) | %lus elapsed, ~%lus remaining\n",
+                   chunk_num, total_chunks, progress, elapsed/1000, eta/1000);
+        }
+
+        // Rate-adaptive gap between chunks
+        pacing_chunk_sent();
+    }
+
+    // Drain any chunks still in the ack handshake before declaring completion
+    if (qos >= 1) {
+        mqttsn_publish_window_flush(5000);
+    }
+
+    sender_send_file_crc(topic, file_crc);
+
+    // This file is now the delta baseline for the next send
+    baseline.block_id = block_id;
+    baseline.total_chunks = total_chunks;
+    baseline.chunk_size = chunk_size;
+    memcpy(baseline.chunk_crc, pending_crc, (size_t)total_chunks * sizeof(uint32_t));
+    baseline.valid = true;
+
+    uint32_t total_time = to_ms_since_boot(get_absolute_time()) - start_time;
+    float speed_kbps = (data_len * 8.0f) / total_time;
+
+    printf("[SENDER] ✓ Streamed transfer complete: %zu bytes in %lu ms (%.2f kbps)",
+           data_len, total_time, speed_kbps);
+    if (skipped > 0) {
+        printf(" | %u/%u chunks unchanged, not sent\n", skipped, total_chunks);
+    } else {
+        printf("\n");
+    }
+
+    return 0;
+}
+
+int send_image_file_delta(const char *topic, const char *filename, uint8_t qos) {
+    delta_requested = true;
+    int rc = send_image_file_qos(topic, filename, qos);
+    delta_requested = false;
+    return rc;
+}
+
 int send_block_transfer_qos(const char *topic, const uint8_t *data, size_t data_len, uint8_t qos) {
     if (data_len > MAX_SUPPORTED_FILE_SIZE) {
         printf("[SENDER] ✗ Data too large: %zu bytes (max %d)\n", data_len, MAX_SUPPORTED_FILE_SIZE);
         return -1;
     }
     
+    // RAM-backed sends keep the fallback chunk size (they are small test
+    // payloads; only file transfers pay for the MTU probe)
+    sender.chunk_size = BLOCK_CHUNK_SIZE;
+
     // Calculate number of chunks
     uint16_t total_chunks = (data_len + BLOCK_CHUNK_SIZE - 1) / BLOCK_CHUNK_SIZE;
     uint16_t block_id = (uint16_t)(to_ms_since_boot(get_absolute_time()) & 0xFFFF);
-    
+
     printf("[SENDER] Starting transfer: BlockID=%u, Size=%zu bytes, Chunks=%u, QoS=%d\n",
            block_id, data_len, total_chunks, qos);
-    
+
+    // Keep a copy in the arena so NACK retransmissions can re-fetch chunks
+    // after the caller's buffer goes out of scope. Bump allocation cannot
+    // fragment; reset_sender reclaims the region wholesale.
+    arena_reset();
+    sender.data = arena_alloc(data_len);
+    if (sender.data == NULL) {
+        return -2;
+    }
+    memcpy(sender.data, data, data_len);
+    sender.data_len = data_len;
+
     // Store sender state for retransmissions
     sender.block_id = block_id;
     sender.total_chunks = total_chunks;
-    
-    // Prepare buffer for ONE chunk (header + data)
-    uint8_t chunk_buffer[sizeof(block_header_t) + BLOCK_CHUNK_SIZE];
+
     uint32_t start_time = to_ms_since_boot(get_absolute_time());
-    
+    pacing_reset();
+
     for (uint16_t chunk_num = 1; chunk_num <= total_chunks; chunk_num++) {
-        // Build chunk header
-        block_header_t *header = (block_header_t *)chunk_buffer;
-        header->block_id = block_id; // Which transfer
-        header->part_num = chunk_num; // THIS IS CHUNK #Nnumber
-        header->total_parts = total_chunks; //Total chunks
-        
         // Calculate data length for this chunk
         size_t offset = (chunk_num - 1) * BLOCK_CHUNK_SIZE;
         size_t remaining = data_len - offset;
         size_t chunk_data_len = (remaining < BLOCK_CHUNK_SIZE) ? remaining : BLOCK_CHUNK_SIZE;
-        header->data_len = chunk_data_len;
-        
-        // Copy chunk data
-        memcpy(chunk_buffer + sizeof(block_header_t), data + offset, chunk_data_len);
-        size_t total_len = sizeof(block_header_t) + chunk_data_len;
-        
-        // Send via MQTT-SN with limited retries (let NACK handle failures)
-        int rc = mqttsn_demo_publish_name(topic, chunk_buffer, total_len);
-        int retry_count = 0;
-        while (rc != 0 && retry_count < 3) {
-            retry_count++;
-            printf("[SENDER] ⚠️  Chunk %u/%u failed (attempt %d/3), retrying...\n", 
-                   chunk_num, total_chunks, retry_count);
-            sleep_ms(50);
-            rc = mqttsn_demo_publish_name(topic, chunk_buffer, total_len);
-        }
-        
-        if (rc != 0) {
-            printf("[SENDER] ⚠️  Chunk %u/%u failed after 3 attempts, continuing (will be retransmitted via NACK)\n", 
-                   chunk_num, total_chunks);
-            // let NACK retransmission handle missing chunks
-        }
-        
+
+        sender_publish_chunk(topic, qos, chunk_num, total_chunks,
+                             data + offset, chunk_data_len);
+
         // Progress indicator with ETA (at 25, 75, 125... to avoid collision with receiver at 50, 100, 150...)
         if ((chunk_num % 50 == 25) || chunk_num == total_chunks) {
             uint32_t elapsed = to_ms_since_boot(get_absolute_time()) - start_time;
@@ -203,19 +1097,21 @@ int send_block_transfer_qos(const char *topic, const uint8_t *data, size_t data_
             printf("[SENDER] %u/%u (%.1f%%) | %lus elapsed, ~%lus remaining\n", 
                    chunk_num, total_chunks, progress, elapsed/1000, eta/1000);
         }
-        
-        // QoS 2 handshake (~200-300ms) provides natural flow control
-        sleep_ms(10);  // Small delay to prevent overwhelming UDP buffers
-        
-        // Extra pause every 20 chunks to let subscriber process and drain buffers
-        if (chunk_num % 20 == 0) {
-            sleep_ms(50);  // Let gateway/subscriber catch up
-        }
+
+        // Rate-adaptive gap between chunks
+        pacing_chunk_sent();
     }
     
+    // Drain any chunks still in the ack handshake before declaring completion
+    if (qos >= 1) {
+        mqttsn_publish_window_flush(5000);
+    }
+
+    sender_send_file_crc(topic, crc32_buffer(data, data_len));
+
     uint32_t total_time = to_ms_since_boot(get_absolute_time()) - start_time;
     float speed_kbps = (data_len * 8.0f) / total_time;
-    
+
     printf("[SENDER] ✓ Transfer complete: %zu bytes in %lu ms (%.2f kbps)\n",
            data_len, total_time, speed_kbps);
     
@@ -232,7 +1128,8 @@ int send_block_transfer(const char *topic, const uint8_t *data, size_t data_len)
 
 void process_block_chunk(const uint8_t *data, size_t len) {
     // Validate input
-    if (!data || len < sizeof(block_header_t) || len > 512) {
+    if (!data || len < sizeof(block_header_t) ||
+        len > sizeof(block_header_t) + BLOCK_CHUNK_SIZE_MAX) {
         return;  // Silently drop invalid chunks
     }
     
@@ -244,176 +1141,147 @@ void process_block_chunk(const uint8_t *data, size_t len) {
     uint16_t part_num = header.part_num;
     uint16_t total_parts = header.total_parts;
     uint16_t data_len = header.data_len;
-    
+    uint16_t chunk_size = (uint16_t)header.chunk_size_64 * 64;
+
+    // Older senders leave the byte zero; treat that as the fallback size
+    if (chunk_size == 0) {
+        chunk_size = BLOCK_CHUNK_SIZE;
+    }
+    if (chunk_size < BLOCK_CHUNK_SIZE || chunk_size > BLOCK_CHUNK_SIZE_MAX) {
+        printf("[RECEIVER] ✗ Invalid chunk size: %u\n", chunk_size);
+        return;
+    }
+
+    // part_num 0 is a control message: MTU probe (ignored), delta
+    // announce, or the end-of-transfer whole-file CRC. For the CRC: if the
+    // transfer is still reassembling (chunks were lost), remember it for
+    // verification at completion; if it already completed, verify the
+    // saved file right away.
+    if (part_num == 0) {
+        if (data_len > 0 && len > sizeof(block_header_t) &&
+            data[sizeof(block_header_t)] == BLOCK_PROBE_MAGIC) {
+            return;  // Path-MTU probe; only the sender's PUBACK matters
+        }
+        if (data_len == 0) {
+            // Whole-file CRC, sent after the last chunk
+            block_rx_ctx_t *ctx = rx_find(block_id);
+            if (ctx != NULL) {
+                ctx->file_crc = header.data_crc;
+                ctx->file_crc_valid = true;
+            } else if (rx_done.pending && rx_done.block_id == block_id) {
+                rx_done.valid = rx_verify_file_crc(rx_done.filename, rx_done.size,
+                                                   header.data_crc);
+                rx_done.pending = false;
+            }
+        } else if (data_len >= sizeof(block_delta_header_t) &&
+                   len >= sizeof(block_header_t) + data_len &&
+                   data[sizeof(block_header_t)] == BLOCK_DELTA_MAGIC) {
+            rx_handle_delta_announce(block_id, total_parts, chunk_size,
+                                     data + sizeof(block_header_t), data_len);
+        }
+        return;
+    }
+
     // Validate
-    if (part_num == 0 || part_num > total_parts || total_parts > BLOCK_MAX_CHUNKS) {
+    if (part_num > total_parts || total_parts > BLOCK_MAX_CHUNKS) {
         printf("[RECEIVER] ✗ Invalid chunk: part=%u, total=%u\n", part_num, total_parts);
         return;
     }
-    
-    if (data_len > BLOCK_CHUNK_SIZE || len < sizeof(block_header_t) + data_len) {
+
+    if (data_len > chunk_size || len < sizeof(block_header_t) + data_len) {
         printf("[RECEIVER] ✗ Invalid data length: %u bytes\n", data_len);
         return;
     }
-    
-    // New transfer
-    if (!receiver.active || receiver.block_id != block_id) {
-        // Validate buffer size first
-        size_t required_buffer = (size_t)total_parts * BLOCK_CHUNK_SIZE;
-        size_t required_mask = total_parts * sizeof(bool);
-        size_t total_required = required_buffer + required_mask;
-        
-        printf("[RECEIVER] New transfer: BlockID=%u, TotalChunks=%u\n", block_id, total_parts);
-        printf("[RECEIVER] Memory required: %zu bytes (buffer=%zu, mask=%zu)\n",
-               total_required, required_buffer, required_mask);
-        
-        // Maximum safe allocation is 55KB to leave headroom
-        if (total_required > 55000) {
-            printf("[RECEIVER] ✗ Transfer too large: %zu bytes (max 55KB)\n", total_required);
-            printf("[RECEIVER] ✗ Reduce file size to ~430 chunks max\n");
-            return;
-        }
-        
-        // Warn if approaching limits
-        if (total_required > 50000) {
-            printf("[RECEIVER] ⚠️  Large transfer: %zu bytes (close to 55KB limit)\n", total_required);
-        }
-        
-        // Clean up old transfer
-        if (receiver.chunk_mask) {
-            free(receiver.chunk_mask);
-            receiver.chunk_mask = NULL;
-        }
-        if (receiver.buffer) {
-            free(receiver.buffer);
-            receiver.buffer = NULL;
-        }
-        
-        // Initialize receiver
-        receiver.block_id = block_id;
-        receiver.total_chunks = total_parts;
-        receiver.received_count = 0;
-        receiver.highest_chunk_received = 0;
-        receiver.buffer_size = required_buffer;
-        
-        // Test allocation first (catches heap exhaustion early)
-        void *test_ptr = malloc(required_buffer);
-        if (!test_ptr) {
-            printf("[RECEIVER] ✗ Heap exhausted - cannot allocate %zu bytes\n", required_buffer);
-            printf("[RECEIVER] ✗ Try: Smaller file, reboot Pico, or disable debug logs\n");
-            receiver.active = false;
-            return;
-        }
-        free(test_ptr);
-        printf("[RECEIVER] ✓ Heap check passed\n");
-        
-        // Allocate chunk mask first (smaller)
-        receiver.chunk_mask = calloc(total_parts, sizeof(bool));
-        if (!receiver.chunk_mask) {
-            printf("[RECEIVER] ✗ Failed to allocate chunk mask (%zu bytes)\n", required_mask);
-            receiver.active = false;
-            return;
-        }
-        printf("[RECEIVER] ✓ Chunk mask allocated: %zu bytes\n", required_mask);
-        
-        // Allocate buffer
-        receiver.buffer = malloc(receiver.buffer_size);
-        if (!receiver.buffer) {
-            printf("[RECEIVER] ✗ Failed to allocate buffer (%zu bytes)\n", receiver.buffer_size);
-            printf("[RECEIVER] ✗ Heap fragmented or exhausted\n");
-            free(receiver.chunk_mask);
-            receiver.chunk_mask = NULL;
-            receiver.active = false;
+
+    // Reject corrupted chunks before touching any state: the chunk's bit
+    // stays clear, so the NACK path re-requests just this chunk instead of
+    // the corruption surfacing as an undecodable file later
+    if (crc32_buffer(data + sizeof(block_header_t), data_len) != header.data_crc) {
+        printf("[RECEIVER] ⚠️  CRC mismatch on chunk %u/%u, dropping (NACK will re-request)\n",
+               part_num, total_parts);
+        return;
+    }
+
+    // Look up (or start) the context for this block_id - transfers from
+    // different senders interleave freely without evicting each other
+    block_rx_ctx_t *ctx = rx_find(block_id);
+    if (ctx == NULL) {
+        ctx = rx_start_transfer(block_id, total_parts, chunk_size);
+        if (ctx == NULL) {
             return;
         }
-        
-        // Zero the buffer to ensure clean state (also tests write access)
-        printf("[RECEIVER] Zeroing buffer...\n");
-        memset(receiver.buffer, 0, receiver.buffer_size);
-        printf("[RECEIVER] ✓ Buffer allocated and zeroed: %zu bytes\n", receiver.buffer_size);
-        printf("[RECEIVER] ✓ Ready to receive chunks\n");
-        
-        receiver.active = true;
-        receiver.last_update = to_ms_since_boot(get_absolute_time());
+    } else if (ctx->chunk_size != chunk_size) {
+        printf("[RECEIVER] ✗ Chunk size changed mid-transfer (%u -> %u), dropping\n",
+               ctx->chunk_size, chunk_size);
+        return;
     }
-    
+
     // Skip duplicates
-    if (receiver.chunk_mask[part_num - 1]) {
+    if (chunk_bit_test(ctx, part_num - 1)) {
         return;
     }
-    
-    // Store chunk data with bounds check
-    size_t offset = (part_num - 1) * BLOCK_CHUNK_SIZE;
-    if (offset + data_len > receiver.buffer_size) {
-        printf("[RECEIVER] ✗ Buffer overflow prevented: offset=%zu, data_len=%u, buffer_size=%zu\n",
-               offset, data_len, receiver.buffer_size);
-        return;
+
+    // Undo the compression stage before the SD write. Each chunk is an
+    // independent LZSS stream, so out-of-order arrival decodes fine.
+    const uint8_t *chunk_data = data + sizeof(block_header_t);
+    uint16_t chunk_len = data_len;
+    static uint8_t plain[BLOCK_CHUNK_SIZE_MAX];
+    if (header.flags & BLOCK_FLAG_COMPRESSED) {
+        size_t n = lzss_decompress(chunk_data, data_len, plain, sizeof(plain));
+        if (n == 0) {
+            printf("[RECEIVER] ✗ Chunk %u/%u failed to decompress, dropping\n",
+                   part_num, total_parts);
+            return;  // Bit stays clear, NACK path will re-request it
+        }
+        chunk_data = plain;
+        chunk_len = (uint16_t)n;
     }
-    
-    // Copy chunk data
-    memcpy(receiver.buffer + offset, data + sizeof(block_header_t), data_len);
-    receiver.chunk_mask[part_num - 1] = true;
-    receiver.received_count++;
-    
+
+    // Write chunk to its file offset (known from part_num)
+    size_t offset = (size_t)(part_num - 1) * ctx->chunk_size;
+    UINT bytes_written = 0;
+    FRESULT res = f_lseek(&ctx->file, offset);
+    if (res == FR_OK) {
+        res = f_write(&ctx->file, chunk_data, chunk_len, &bytes_written);
+    }
+    if (res != FR_OK || bytes_written != chunk_len) {
+        printf("[RECEIVER] ✗ SD write failed at offset %zu (err=%d)\n", offset, res);
+        return;  // Chunk stays unmasked, NACK path will re-request it
+    }
+
+    // Remember the file magic for type detection on completion
+    if (part_num == 1 && chunk_len >= 4) {
+        memcpy(ctx->magic, chunk_data, 4);
+        ctx->magic_valid = true;
+    }
+    if (part_num == total_parts) {
+        ctx->last_chunk_len = chunk_len;
+    }
+
+    chunk_bit_set(ctx, part_num - 1);
+    ctx->received_count++;
+    perf.chunks_received++;
+
     // Track highest chunk number seen (indicates send progress)
-    if (part_num > receiver.highest_chunk_received) {
-        receiver.highest_chunk_received = part_num;
+    if (part_num > ctx->highest_chunk_received) {
+        ctx->highest_chunk_received = part_num;
     }
-    
+
     // Yield CPU to prevent watchdog timeout
     tight_loop_contents();
-    receiver.last_update = to_ms_since_boot(get_absolute_time());
-    
+    ctx->last_update = to_ms_since_boot(get_absolute_time());
+
     // Progress indicator (show every 50 chunks for cleaner output)
-    if (receiver.received_count % 50 == 0 || receiver.received_count == receiver.total_chunks) {
-        float progress = (receiver.received_count * 100.0f) / receiver.total_chunks;
-        uint16_t missing = receiver.total_chunks - receiver.received_count;
-        printf("\n[BLOCK] %u/%u chunks (%.1f%%) | Missing: %u\n",
-               receiver.received_count, receiver.total_chunks, progress, missing);
+    if (ctx->received_count % 50 == 0 || ctx->received_count == ctx->total_chunks) {
+        float progress = (ctx->received_count * 100.0f) / ctx->total_chunks;
+        uint16_t missing = ctx->total_chunks - ctx->received_count;
+        printf("\n[BLOCK] ID=%u: %u/%u chunks (%.1f%%) | Missing: %u\n",
+               ctx->block_id, ctx->received_count, ctx->total_chunks, progress, missing);
     }
-    
+
     // Transfer complete
-    if (receiver.received_count == receiver.total_chunks) {
-        printf("\n========================================\n");
-        printf("[SUCCESS] Transfer complete: %u chunks\n", receiver.total_chunks);
-        
-        // Calculate actual data size (last chunk may be partial)
-        size_t total_size = ((receiver.total_chunks - 1) * BLOCK_CHUNK_SIZE) + data_len;
-        
-        // Detect file type and save to SD card
-        const char *extension = ".bin";
-        if (total_size >= 3) {
-            if (receiver.buffer[0] == 0xFF && receiver.buffer[1] == 0xD8 && receiver.buffer[2] == 0xFF) {
-                extension = ".jpg";
-            } else if (receiver.buffer[0] == 0x89 && receiver.buffer[1] == 0x50 && 
-                       receiver.buffer[2] == 0x4E && receiver.buffer[3] == 0x47) {
-                extension = ".png";
-            } else if (receiver.buffer[0] == 0x47 && receiver.buffer[1] == 0x49 && 
-                       receiver.buffer[2] == 0x46) {
-                extension = ".gif";
-            }
-        }
-        
-        // Generate filename
-        char filename[64];
-        snprintf(filename, sizeof(filename), "block_%u%s", block_id, extension);
-        
-        // Write to SD card
-        int rc = sd_card_write_file(filename, receiver.buffer, total_size);
-        if (rc == 0) {
-            printf("[SD CARD] Saved: %s (%zu bytes)\n", filename, total_size);
-            printf("========================================\n\n");
-        } else {
-            printf("[ERROR] SD card save failed (err=%d)\n", rc);
-            printf("========================================\n\n");
-        }
-        
-        // Clean up
-        free(receiver.chunk_mask);
-        receiver.chunk_mask = NULL;
-        free(receiver.buffer);
-        receiver.buffer = NULL;
-        receiver.active = false;
+    if (ctx->received_count == ctx->total_chunks) {
+        rx_finalize(ctx);
     }
 }
 
@@ -422,107 +1290,240 @@ void process_block_chunk(const uint8_t *data, size_t len) {
 // ============================================================================
 
 int block_transfer_get_missing_count(void) {
-    if (!receiver.active) return 0;
-    return receiver.total_chunks - receiver.received_count;
-}
+    // Popcount the bitmaps a word at a time (33 instructions per 1000 chunks)
+    int missing = 0;
+    for (int i = 0; i < BLOCK_RX_CONTEXTS; i++) {
+        block_rx_ctx_t *ctx = &rx_table[i];
+        if (!ctx->active) continue;
 
-int block_transfer_request_missing_chunks(void) {
-    if (!receiver.active) {
-        return -1;
+        uint32_t received = 0;
+        uint16_t words = (ctx->total_chunks + 31) / 32;
+        for (uint16_t w = 0; w < words; w++) {
+            received += __builtin_popcount(ctx->chunk_bitmap[w]);
+        }
+        missing += ctx->total_chunks - received;
     }
-    
-    if (receiver.received_count == receiver.total_chunks) {
+    return missing;
+}
+
+// Build and send the SACK for one transfer. Same return codes as the public
+// wrapper below.
+static int rx_request_missing(block_rx_ctx_t *ctx) {
+    if (ctx->received_count == ctx->total_chunks) {
         return -2;  // Already complete
     }
-    
+
     // Wait for publisher to finish sending before requesting retransmissions
     uint32_t now = to_ms_since_boot(get_absolute_time());
-    uint32_t time_since_last_chunk = now - receiver.last_update;
-    
+    uint32_t time_since_last_chunk = now - ctx->last_update;
+
     if (time_since_last_chunk < 3000) {
         // Publisher still actively sending chunks, don't spam with NACKs yet
         // Wait until there's a 3-second gap (indicating send complete or stall)
         return -4;  // Not an error, just waiting
     }
-    
+
     // Only request chunks up to highest received (don't ask for chunks not sent yet)
-    uint16_t request_up_to = receiver.highest_chunk_received;
+    uint16_t request_up_to = ctx->highest_chunk_received;
     if (request_up_to == 0) {
         printf("[RECEIVER] No chunks received yet, waiting...\n");
         return -3;
     }
-    
-    // Build NACK message: "NACK:BLOCK=123,CHUNKS=1,3,5-8,10"
-    char nack_msg[256];
-    int pos = snprintf(nack_msg, sizeof(nack_msg), "NACK:BLOCK=%u,CHUNKS=", receiver.block_id);
-    
-    int count = 0;
-    int range_start = -1;
-    int range_end = -1;
-    
-    // Only check chunks up to highest received
-    for (uint16_t i = 0; i < request_up_to && i < receiver.total_chunks; i++) {
-        if (!receiver.chunk_mask[i]) {
-            uint16_t chunk_num = i + 1;
-            
-            if (range_start == -1) {
-                range_start = chunk_num;
-                range_end = chunk_num;
-            } else if (chunk_num == range_end + 1) {
-                range_end = chunk_num;
-            } else {
-                // Write previous range
-                if (count > 0) pos += snprintf(nack_msg + pos, sizeof(nack_msg) - pos, ",");
-                if (range_start == range_end) {
-                    pos += snprintf(nack_msg + pos, sizeof(nack_msg) - pos, "%d", range_start);
-                } else {
-                    pos += snprintf(nack_msg + pos, sizeof(nack_msg) - pos, "%d-%d", range_start, range_end);
-                }
-                count++;
-                range_start = chunk_num;
-                range_end = chunk_num;
-            }
-        }
+
+    // Tail loss: everything up to the highest chunk seen arrived, but the
+    // transfer is incomplete - the end of the stream was lost. The 3s quiet
+    // gate above means the sender is done sending, so request the full
+    // range instead of waiting forever for a chunk that will never come.
+    if (request_up_to < ctx->total_chunks &&
+        ctx->received_count >= request_up_to) {
+        request_up_to = ctx->total_chunks;
     }
-    
-    // Write last range
-    if (range_start != -1) {
-        if (count > 0) pos += snprintf(nack_msg + pos, sizeof(nack_msg) - pos, ",");
-        if (range_start == range_end) {
-            pos += snprintf(nack_msg + pos, sizeof(nack_msg) - pos, "%d", range_start);
-        } else {
-            pos += snprintf(nack_msg + pos, sizeof(nack_msg) - pos, "%d-%d", range_start, range_end);
+
+    if (request_up_to > ctx->total_chunks) {
+        request_up_to = ctx->total_chunks;
+    }
+
+    // Build binary SACK: header + missing-chunk bitmap. The bitmap is just
+    // the inverted receive bitmap, so any loss pattern fits in one packet
+    // (the old ASCII range list overflowed with scattered loss).
+    uint16_t sack_words = (request_up_to + 31) / 32;
+    uint8_t sack_msg[sizeof(block_sack_header_t) + BLOCK_BITMAP_WORDS * 4];
+
+    block_sack_header_t *sack = (block_sack_header_t *)sack_msg;
+    sack->magic = BLOCK_SACK_MAGIC;
+    sack->reserved = 0;
+    sack->block_id = ctx->block_id;
+    sack->up_to = request_up_to;
+
+    uint32_t missing_total = 0;
+    uint8_t *bitmap_out = sack_msg + sizeof(block_sack_header_t);
+    for (uint16_t w = 0; w < sack_words; w++) {
+        uint32_t missing = ~ctx->chunk_bitmap[w];
+
+        // Mask off bits beyond request_up_to in the last word
+        uint16_t bits_in_word = request_up_to - w * 32;
+        if (bits_in_word < 32) {
+            missing &= (1u << bits_in_word) - 1;
         }
-        count++;  // Count the last range
+
+        missing_total += __builtin_popcount(missing);
+        memcpy(bitmap_out + w * 4, &missing, 4);  // Little-endian, unaligned-safe
     }
-    
-    // Don't send empty NACK if no chunks are missing (within the range we're checking)
-    if (count == 0) {
-        printf("[NACK] No missing chunks in range 1-%u (still waiting for chunks %u-%u)\n",
-               request_up_to, request_up_to + 1, receiver.total_chunks);
+
+    // Don't send an empty request if nothing is missing in the checked range
+    if (missing_total == 0) {
+        printf("[NACK] BlockID=%u: no missing chunks in range 1-%u (still waiting for %u-%u)\n",
+               ctx->block_id, request_up_to, request_up_to + 1, ctx->total_chunks);
         return -5;  // Not an error, just nothing to request yet
     }
-    
-    // Send NACK via MQTT-SN QoS 0 (fast, non-blocking)
+
+    size_t sack_len = sizeof(block_sack_header_t) + (size_t)sack_words * 4;
+
+    // Send SACK via MQTT-SN QoS 0 (fast, non-blocking)
     int prev_qos = mqttsn_get_qos();
     mqttsn_set_qos(0);
-    int rc = mqttsn_demo_publish_name("pico/retransmit", (uint8_t *)nack_msg, strlen(nack_msg));
+    int rc = mqttsn_demo_publish_name("pico/retransmit", sack_msg, sack_len);
     mqttsn_set_qos(prev_qos);
-    
+
     if (rc == 0) {
-        printf("\n[NACK] Requesting %u missing chunks (up to chunk %u): %s\n", 
-               count, request_up_to, nack_msg);
+        printf("\n[NACK] BlockID=%u: requesting %lu missing chunks (up to chunk %u, %zu-byte SACK)\n",
+               ctx->block_id, missing_total, request_up_to, sack_len);
     } else {
-        printf("\n[ERROR] Failed to send NACK (err=%d)\n", rc);
+        printf("\n[ERROR] Failed to send SACK (err=%d)\n", rc);
     }
-    
+
     return rc;
 }
 
+int block_transfer_request_missing_chunks(void) {
+    int sent = 0;
+    int last_rc = -1;  // -1 = no active transfer
+
+    for (int i = 0; i < BLOCK_RX_CONTEXTS; i++) {
+        if (!rx_table[i].active) continue;
+        last_rc = rx_request_missing(&rx_table[i]);
+        if (last_rc == 0) sent++;
+    }
+
+    return (sent > 0) ? 0 : last_rc;
+}
+
 // ============================================================================
 // SENDER: HANDLE RETRANSMISSION REQUEST
 // ============================================================================
 
+// Re-read one chunk and republish it at QoS 0. Shared by the ASCII NACK and
+// binary SACK handlers. Returns 0 on success.
+static int sender_retransmit_chunk(int chunk_num) {
+    // Static for the same stack reason as sender_publish_chunk
+    static uint8_t chunk_buffer[sizeof(block_header_t) + BLOCK_CHUNK_SIZE_MAX];
+
+    if (chunk_num < 1 || chunk_num > sender.total_chunks) {
+        return -1;
+    }
+
+    // Build chunk (file-backed transfers re-read the chunk from SD)
+    size_t chunk_data_len = 0;
+    if (sender_fetch_chunk(chunk_num, chunk_buffer + sizeof(block_header_t),
+                           &chunk_data_len) != 0) {
+        printf("[SENDER] ✗ Failed to fetch chunk %d for retransmit\n", chunk_num);
+        return -2;
+    }
+
+    // Compress just like the first transmission (receiver checks the flag,
+    // so a raw resend of a compressed chunk would also be fine)
+    static uint8_t compressed[LZSS_MAX_COMPRESSED(BLOCK_CHUNK_SIZE_MAX)];
+    uint8_t flags = 0;
+    size_t comp_len = lzss_compress(chunk_buffer + sizeof(block_header_t),
+                                    chunk_data_len, compressed, sizeof(compressed));
+    if (comp_len > 0 && comp_len < chunk_data_len) {
+        memcpy(chunk_buffer + sizeof(block_header_t), compressed, comp_len);
+        chunk_data_len = comp_len;
+        flags = BLOCK_FLAG_COMPRESSED;
+    }
+
+    block_header_t *header = (block_header_t *)chunk_buffer;
+    header->block_id = sender.block_id;
+    header->part_num = chunk_num;
+    header->total_parts = sender.total_chunks;
+    header->data_len = chunk_data_len;
+    header->flags = flags;
+    header->chunk_size_64 = (uint8_t)(sender.chunk_size / 64);
+    header->data_crc = crc32_buffer(chunk_buffer + sizeof(block_header_t), chunk_data_len);
+
+    size_t total_len = sizeof(block_header_t) + chunk_data_len;
+
+    // Retransmit with QoS 0 for speed
+    int prev_qos = mqttsn_get_qos();
+    mqttsn_set_qos(0);
+    int rc = mqttsn_demo_publish_name("pico/chunks", chunk_buffer, total_len);
+    mqttsn_set_qos(prev_qos);
+
+    if (rc != 0) {
+        printf("[SENDER] ✗ Failed to retransmit chunk %d\n", chunk_num);
+        return -3;
+    }
+
+    retx_total++;  // Loss signal for the pacing controller
+    perf.retransmits++;
+    perf.chunks_sent++;
+    // Light pacing for retransmissions (QoS 0 needs some delay)
+    sleep_ms(5);
+    return 0;
+}
+
+// Binary SACK: block_sack_header_t + missing-chunk bitmap (see header).
+// Resends every chunk whose bit is set, in one pass.
+int block_transfer_handle_retransmit_binary(const uint8_t *payload, size_t len) {
+    if (!sender.active) {
+        printf("[SENDER] ✗ No active transfer for retransmission\n");
+        return -1;
+    }
+
+    if (len < sizeof(block_sack_header_t) || payload[0] != BLOCK_SACK_MAGIC) {
+        printf("[SENDER] ✗ Invalid SACK packet (len=%zu)\n", len);
+        return -3;
+    }
+
+    block_sack_header_t sack;
+    memcpy(&sack, payload, sizeof(sack));
+
+    if (sack.block_id != sender.block_id) {
+        printf("[SENDER] ✗ SACK for different block: %u (current=%u)\n",
+               sack.block_id, sender.block_id);
+        return -2;
+    }
+
+    uint16_t sack_words = (sack.up_to + 31) / 32;
+    if (len < sizeof(block_sack_header_t) + (size_t)sack_words * 4) {
+        printf("[SENDER] ✗ Truncated SACK bitmap\n");
+        return -3;
+    }
+
+    printf("[SENDER] 📥 Processing SACK: BlockID=%u, up to chunk %u\n",
+           sack.block_id, sack.up_to);
+
+    const uint8_t *bitmap_in = payload + sizeof(block_sack_header_t);
+    int retx_count = 0;
+
+    for (uint16_t w = 0; w < sack_words; w++) {
+        uint32_t missing;
+        memcpy(&missing, bitmap_in + w * 4, 4);
+
+        while (missing) {
+            int bit = __builtin_ctz(missing);
+            missing &= missing - 1;  // Clear lowest set bit
+
+            if (sender_retransmit_chunk(w * 32 + bit + 1) == 0) {
+                retx_count++;
+            }
+        }
+    }
+
+    printf("[SENDER] ✓ Retransmitted %d chunks\n", retx_count);
+    return 0;
+}
+
 int block_transfer_handle_retransmit_request(const char *request_msg) {
     if (!sender.active) {
         printf("[SENDER] ✗ No active transfer for retransmission\n");
@@ -554,10 +1555,9 @@ int block_transfer_handle_retransmit_request(const char *request_msg) {
     char chunks_copy[256];
     strncpy(chunks_copy, chunks_ptr, sizeof(chunks_copy) - 1);
     chunks_copy[sizeof(chunks_copy) - 1] = '\0';
-    
-    uint8_t chunk_buffer[sizeof(block_header_t) + BLOCK_CHUNK_SIZE];
+
     int retx_count = 0;
-    
+
     char *token = strtok(chunks_copy, ",");
     while (token) {
         int start, end;
@@ -569,45 +1569,17 @@ int block_transfer_handle_retransmit_request(const char *request_msg) {
             sscanf(token, "%d", &start);
             end = start;
         }
-        
+
         // Retransmit chunks in range
         for (int chunk_num = start; chunk_num <= end; chunk_num++) {
-            if (chunk_num < 1 || chunk_num > sender.total_chunks) {
-                continue;
-            }
-            
-            // Build chunk
-            block_header_t *header = (block_header_t *)chunk_buffer;
-            header->block_id = sender.block_id;
-            header->part_num = chunk_num;
-            header->total_parts = sender.total_chunks;
-            
-            size_t offset = (chunk_num - 1) * BLOCK_CHUNK_SIZE;
-            size_t remaining = sender.data_len - offset;
-            size_t chunk_data_len = (remaining < BLOCK_CHUNK_SIZE) ? remaining : BLOCK_CHUNK_SIZE;
-            header->data_len = chunk_data_len;
-            
-            memcpy(chunk_buffer + sizeof(block_header_t), sender.data + offset, chunk_data_len);
-            size_t total_len = sizeof(block_header_t) + chunk_data_len;
-            
-            // Retransmit with QoS 0 for speed
-            int prev_qos = mqttsn_get_qos();
-            mqttsn_set_qos(0);
-            int rc = mqttsn_demo_publish_name("pico/chunks", chunk_buffer, total_len);
-            mqttsn_set_qos(prev_qos);
-            
-            if (rc == 0) {
+            if (sender_retransmit_chunk(chunk_num) == 0) {
                 retx_count++;
-                // Light pacing for retransmissions (QoS 0 needs some delay)
-                sleep_ms(5);
-            } else {
-                printf("[SENDER] ✗ Failed to retransmit chunk %d\n", chunk_num);
             }
         }
-        
+
         token = strtok(NULL, ",");
     }
-    
+
     printf("[SENDER] ✓ Retransmitted %d chunks\n", retx_count);
     return 0;
 }
@@ -617,34 +1589,46 @@ int block_transfer_handle_retransmit_request(const char *request_msg) {
 // ============================================================================
 
 bool block_transfer_is_active(void) {
-    return receiver.active;
+    for (int i = 0; i < BLOCK_RX_CONTEXTS; i++) {
+        if (rx_table[i].active) return true;
+    }
+    return false;
 }
 
 void block_transfer_print_status(void) {
-    if (receiver.active) {
-        float progress = (receiver.received_count * 100.0f) / receiver.total_chunks;
-        uint16_t missing = receiver.total_chunks - receiver.received_count;
-        printf("[RECEIVER] Status: %u/%u chunks (%.1f%%) | Missing: %u\n",
-               receiver.received_count, receiver.total_chunks, progress, missing);
-    } else {
+    bool any = false;
+    for (int i = 0; i < BLOCK_RX_CONTEXTS; i++) {
+        block_rx_ctx_t *ctx = &rx_table[i];
+        if (!ctx->active) continue;
+        any = true;
+        float progress = (ctx->received_count * 100.0f) / ctx->total_chunks;
+        uint16_t missing = ctx->total_chunks - ctx->received_count;
+        printf("[RECEIVER] BlockID=%u: %u/%u chunks (%.1f%%) | Missing: %u\n",
+               ctx->block_id, ctx->received_count, ctx->total_chunks, progress, missing);
+    }
+    if (!any) {
         printf("[RECEIVER] No active transfer\n");
     }
 }
 
 void block_transfer_check_timeout(void) {
-    if (!receiver.active) return;
-    
     uint32_t now = to_ms_since_boot(get_absolute_time());
-    uint32_t elapsed = now - receiver.last_update;
-    
-    // Timeout after 60 seconds of no chunks
-    if (elapsed > 60000) {
-        printf("[RECEIVER] ⚠ Transfer timeout: no chunks for %lu seconds\n", elapsed / 1000);
-        
-        // Clean up
-        if (receiver.chunk_mask) free(receiver.chunk_mask);
-        if (receiver.buffer) free(receiver.buffer);
-        receiver.active = false;
+
+    for (int i = 0; i < BLOCK_RX_CONTEXTS; i++) {
+        block_rx_ctx_t *ctx = &rx_table[i];
+        if (!ctx->active) continue;
+
+        uint32_t elapsed = now - ctx->last_update;
+
+        // Timeout after 60 seconds of no chunks
+        if (elapsed > 60000) {
+            printf("[RECEIVER] ⚠ BlockID=%u timeout: no chunks for %lu seconds\n",
+                   ctx->block_id, elapsed / 1000);
+
+            // Clean up
+            receiver_discard_file(ctx);
+            ctx->active = false;
+        }
     }
 }
 
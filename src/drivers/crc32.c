@@ -0,0 +1,110 @@
+// crc32.c
+// CRC-32 via the RP2040 DMA sniffer: data is pumped through a DMA channel
+// into a throwaway word while the sniffer accumulates the checksum, so the
+// CPU cost of verifying a chunk is just starting the channel. One sniffer
+// exists per chip, so access is serialized with a mutex (the sender on
+// core 0 and the pipeline on core 1 can both checksum at once).
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/mutex.h"
+#include "hardware/dma.h"
+#include "drivers/crc32.h"
+
+static int crc_dma_chan = -1;
+static mutex_t crc_mutex;
+static bool crc_initialized = false;
+
+// The sniffer accumulates CRC-32R (bit-reversed data order, which matches
+// the byte-wise reflected CRC every other implementation uses); the final
+// reverse + invert is done in software so the raw accumulator can be
+// carried across crc32_update() calls.
+static uint32_t bit_reverse32(uint32_t v) {
+    v = ((v >> 1) & 0x55555555u) | ((v & 0x55555555u) << 1);
+    v = ((v >> 2) & 0x33333333u) | ((v & 0x33333333u) << 2);
+    v = ((v >> 4) & 0x0F0F0F0Fu) | ((v & 0x0F0F0F0Fu) << 4);
+    v = ((v >> 8) & 0x00FF00FFu) | ((v & 0x00FF00FFu) << 8);
+    return (v >> 16) | (v << 16);
+}
+
+// Bitwise software fallback for when no DMA channel is free. The sniffer
+// accumulates in CRC32R order - the bit-reverse of the byte-wise zlib
+// accumulator - so the state is reversed into zlib order for the byte
+// loop and reversed back on the way out. Both paths then carry the same
+// raw accumulator and share crc32_finalize(), so a software-fallback
+// node interoperates with a hardware-path peer on the wire.
+static uint32_t crc32_update_soft(uint32_t state, const uint8_t *data, size_t len) {
+    state = bit_reverse32(state);
+    while (len--) {
+        state ^= *data++;
+        for (int i = 0; i < 8; i++) {
+            state = (state >> 1) ^ (0xEDB88320u & -(state & 1u));
+        }
+    }
+    return bit_reverse32(state);
+}
+
+void crc32_init(void) {
+    if (crc_initialized) return;
+
+    mutex_init(&crc_mutex);
+    crc_dma_chan = dma_claim_unused_channel(false);
+    if (crc_dma_chan >= 0) {
+        printf("[CRC32] ✓ DMA sniffer on channel %d\n", crc_dma_chan);
+    } else {
+        printf("[CRC32] ⚠️  No free DMA channel, using software CRC\n");
+    }
+    crc_initialized = true;
+
+    // Known-answer self-check: "123456789" -> 0xCBF43926 (the standard
+    // CRC-32 check value). Run the software path always and the active
+    // path once, so an accumulator-convention mismatch between the two
+    // is caught at boot instead of as silent chunk CRC failures.
+    const uint8_t check[] = "123456789";
+    uint32_t soft = crc32_finalize(crc32_update_soft(CRC32_INIT, check, 9));
+    uint32_t active = crc32_finalize(crc32_update(CRC32_INIT, check, 9));
+    if (soft != 0xCBF43926u || active != 0xCBF43926u) {
+        printf("[CRC32] ✗ Self-check failed: soft=%08lX active=%08lX (want CBF43926)\n",
+               soft, active);
+    }
+}
+
+uint32_t crc32_update(uint32_t state, const void *data, size_t len) {
+    if (len == 0) return state;
+    if (!crc_initialized) crc32_init();
+
+    if (crc_dma_chan < 0) {
+        return crc32_update_soft(state, (const uint8_t *)data, len);
+    }
+
+    mutex_enter_blocking(&crc_mutex);
+
+    // Byte-wide memory-to-memory copy into a sink word; only the sniffer
+    // result matters. 8-bit transfers mean any length works.
+    static uint32_t sink;
+    dma_channel_config c = dma_channel_get_default_config(crc_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_sniff_enable(&c, true);
+
+    dma_sniffer_enable(crc_dma_chan, DMA_SNIFF_CTRL_CALC_VALUE_CRC32R, true);
+    dma_sniffer_set_data_accumulator(state);
+
+    dma_channel_configure(crc_dma_chan, &c, &sink, data, len, true);
+    dma_channel_wait_for_finish_blocking(crc_dma_chan);
+
+    state = dma_sniffer_get_data_accumulator();
+    dma_sniffer_disable();
+
+    mutex_exit(&crc_mutex);
+    return state;
+}
+
+uint32_t crc32_finalize(uint32_t state) {
+    return ~bit_reverse32(state);
+}
+
+uint32_t crc32_buffer(const void *data, size_t len) {
+    return crc32_finalize(crc32_update(CRC32_INIT, data, len));
+}
@@ -0,0 +1,102 @@
+// lzss.c - Tiny LZSS codec for block-transfer chunks
+//
+// Classic LZSS with a flag byte per 8 items. Greedy longest-match search
+// is O(n^2), which is fine for the 128-byte chunks we feed it; there is
+// deliberately no hash chain or ring buffer to keep the RAM cost at zero.
+
+#include "drivers/lzss.h"
+
+#define LZSS_MIN_MATCH 3
+#define LZSS_MAX_MATCH 18   // LZSS_MIN_MATCH + 4-bit length field
+#define LZSS_MAX_OFFSET 4096  // 12-bit offset field, stored as offset-1
+
+size_t lzss_compress(const uint8_t *in, size_t in_len,
+                     uint8_t *out, size_t out_max) {
+    size_t in_pos = 0;
+    size_t out_pos = 0;
+
+    while (in_pos < in_len) {
+        if (out_pos >= out_max) {
+            return 0;
+        }
+        size_t flag_pos = out_pos++;  // Filled in once the group is done
+        uint8_t flags = 0;
+
+        for (int bit = 0; bit < 8 && in_pos < in_len; bit++) {
+            // Longest match in the window behind the current position
+            size_t max_len = in_len - in_pos;
+            if (max_len > LZSS_MAX_MATCH) {
+                max_len = LZSS_MAX_MATCH;
+            }
+            size_t window = (in_pos > LZSS_MAX_OFFSET) ? in_pos - LZSS_MAX_OFFSET : 0;
+            size_t best_len = 0;
+            size_t best_off = 0;
+            for (size_t cand = window; cand < in_pos; cand++) {
+                size_t len = 0;
+                while (len < max_len && in[cand + len] == in[in_pos + len]) {
+                    len++;
+                }
+                if (len > best_len) {
+                    best_len = len;
+                    best_off = in_pos - cand;
+                }
+            }
+
+            if (best_len >= LZSS_MIN_MATCH) {
+                if (out_pos + 2 > out_max) {
+                    return 0;
+                }
+                flags |= (uint8_t)(1u << bit);
+                uint16_t off = (uint16_t)(best_off - 1);
+                out[out_pos++] = (uint8_t)(off >> 4);
+                out[out_pos++] = (uint8_t)(((off & 0xF) << 4) |
+                                           (best_len - LZSS_MIN_MATCH));
+                in_pos += best_len;
+            } else {
+                if (out_pos >= out_max) {
+                    return 0;
+                }
+                out[out_pos++] = in[in_pos++];
+            }
+        }
+        out[flag_pos] = flags;
+    }
+    return out_pos;
+}
+
+size_t lzss_decompress(const uint8_t *in, size_t in_len,
+                       uint8_t *out, size_t out_max) {
+    size_t in_pos = 0;
+    size_t out_pos = 0;
+
+    while (in_pos < in_len) {
+        uint8_t flags = in[in_pos++];
+
+        for (int bit = 0; bit < 8 && in_pos < in_len; bit++) {
+            if (flags & (1u << bit)) {
+                if (in_pos + 2 > in_len) {
+                    return 0;
+                }
+                size_t off = (((size_t)in[in_pos] << 4) |
+                              ((size_t)in[in_pos + 1] >> 4)) + 1;
+                size_t len = (size_t)(in[in_pos + 1] & 0xF) + LZSS_MIN_MATCH;
+                in_pos += 2;
+
+                if (off > out_pos || out_pos + len > out_max) {
+                    return 0;
+                }
+                // Byte-by-byte so overlapping matches (run encoding) work
+                for (size_t k = 0; k < len; k++) {
+                    out[out_pos] = out[out_pos - off];
+                    out_pos++;
+                }
+            } else {
+                if (out_pos >= out_max) {
+                    return 0;
+                }
+                out[out_pos++] = in[in_pos++];
+            }
+        }
+    }
+    return out_pos;
+}
@@ -0,0 +1,62 @@
+// perf_counters.c
+// Runtime performance counters published on pico/stats. Modules increment
+// the fields of `perf` inline; everything expensive (rates, heap sampling,
+// snprintf) lives here and runs once per publish interval.
+
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+#include "pico/stdlib.h"
+#include "drivers/arena.h"
+#include "drivers/perf_counters.h"
+#include "drivers/udp_driver.h"
+#include "protocol/mqttsn/mqttsn_client.h"
+
+perf_counters_t perf = {0};
+
+// Heap high-water mark: newlib's allocated-bytes figure sampled at each
+// publish. Sampled rather than exact, but a leak or a burst allocation
+// still shows up as a rising hwm between snapshots.
+static uint32_t heap_hwm = 0;
+
+int perf_counters_publish(void) {
+    static uint32_t last_ms = 0;
+    static uint32_t last_sent = 0;
+    static uint32_t last_received = 0;
+
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    uint32_t sent = perf.chunks_sent;
+    uint32_t received = perf.chunks_received;
+
+    // Per-second rates from the deltas since the last publish
+    uint32_t tx_rate = 0, rx_rate = 0;
+    if (last_ms != 0 && now > last_ms) {
+        uint32_t interval = now - last_ms;
+        tx_rate = ((sent - last_sent) * 1000) / interval;
+        rx_rate = ((received - last_received) * 1000) / interval;
+    }
+    last_ms = now;
+    last_sent = sent;
+    last_received = received;
+
+    struct mallinfo mi = mallinfo();
+    if ((uint32_t)mi.uordblks > heap_hwm) {
+        heap_hwm = mi.uordblks;
+    }
+
+    // One compact key=value line; the dashboard splits on spaces
+    char msg[160];
+    snprintf(msg, sizeof(msg),
+             "up=%lu tx=%lu rx=%lu txps=%lu rxps=%lu retx=%lu drop=%lu rtt=%lu heap=%lu arena=%zu/%zu",
+             now / 1000, sent, received, tx_rate, rx_rate,
+             perf.retransmits, wifi_udp_get_rx_dropped(),
+             mqttsn_publish_window_srtt_ms(), heap_hwm,
+             arena_used(), arena_high_water());
+
+    int prev_qos = mqttsn_get_qos();
+    mqttsn_set_qos(0);
+    int rc = mqttsn_demo_publish_name("pico/stats", (const uint8_t *)msg, (int)strlen(msg));
+    mqttsn_set_qos(prev_qos);
+
+    return rc;
+}
@@ -2,6 +2,7 @@
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
 #include "hardware/gpio.h"
+#include "hardware/dma.h"
 #include "ff.h"  // FatFs library
 #include "diskio.h"  // For disk_status and STA_* flags
 #include <string.h>
@@ -22,8 +23,11 @@
 #define CMD0  0x40  // Software reset
 #define CMD1  0x41  // Send operating condition
 #define CMD8  0x48  // Send interface condition
+#define CMD12 0x4C  // Stop transmission (ends CMD18)
 #define CMD17 0x51  // Read single block
+#define CMD18 0x52  // Read multiple blocks
 #define CMD24 0x58  // Write single block
+#define CMD25 0x59  // Write multiple blocks
 #define CMD55 0x77  // Application command prefix
 #define ACMD41 0x69 // Application command 41
 
@@ -334,6 +338,68 @@ static uint8_t sd_command(uint8_t cmd, uint32_t arg, uint8_t crc) {
     return resp;
 }
 
+// DMA channels for bulk sector transfers (claimed lazily on first use).
+// The SPI is full duplex, so every transfer runs both directions: reads feed
+// a constant 0xFF out while DMA captures MISO; writes stream the buffer out
+// while DMA drains the RX FIFO into a scratch byte.
+static int sd_dma_tx = -1;
+static int sd_dma_rx = -1;
+
+static void sd_dma_claim(void) {
+    if (sd_dma_tx < 0) {
+        sd_dma_tx = dma_claim_unused_channel(true);
+        sd_dma_rx = dma_claim_unused_channel(true);
+    }
+}
+
+// Read len bytes from the card via DMA (CPU is free while this runs)
+static void sd_spi_dma_read(uint8_t *dst, size_t len) {
+    static const uint8_t tx_fill = 0xFF;
+
+    sd_dma_claim();
+
+    dma_channel_config tc = dma_channel_get_default_config(sd_dma_tx);
+    channel_config_set_transfer_data_size(&tc, DMA_SIZE_8);
+    channel_config_set_read_increment(&tc, false);
+    channel_config_set_write_increment(&tc, false);
+    channel_config_set_dreq(&tc, spi_get_dreq(SD_SPI, true));
+    dma_channel_configure(sd_dma_tx, &tc, &spi_get_hw(SD_SPI)->dr, &tx_fill, len, false);
+
+    dma_channel_config rc = dma_channel_get_default_config(sd_dma_rx);
+    channel_config_set_transfer_data_size(&rc, DMA_SIZE_8);
+    channel_config_set_read_increment(&rc, false);
+    channel_config_set_write_increment(&rc, true);
+    channel_config_set_dreq(&rc, spi_get_dreq(SD_SPI, false));
+    dma_channel_configure(sd_dma_rx, &rc, dst, &spi_get_hw(SD_SPI)->dr, len, false);
+
+    dma_start_channel_mask((1u << sd_dma_tx) | (1u << sd_dma_rx));
+    dma_channel_wait_for_finish_blocking(sd_dma_rx);
+}
+
+// Write len bytes to the card via DMA
+static void sd_spi_dma_write(const uint8_t *src, size_t len) {
+    static uint8_t rx_sink;
+
+    sd_dma_claim();
+
+    dma_channel_config tc = dma_channel_get_default_config(sd_dma_tx);
+    channel_config_set_transfer_data_size(&tc, DMA_SIZE_8);
+    channel_config_set_read_increment(&tc, true);
+    channel_config_set_write_increment(&tc, false);
+    channel_config_set_dreq(&tc, spi_get_dreq(SD_SPI, true));
+    dma_channel_configure(sd_dma_tx, &tc, &spi_get_hw(SD_SPI)->dr, src, len, false);
+
+    dma_channel_config rc = dma_channel_get_default_config(sd_dma_rx);
+    channel_config_set_transfer_data_size(&rc, DMA_SIZE_8);
+    channel_config_set_read_increment(&rc, false);
+    channel_config_set_write_increment(&rc, false);
+    channel_config_set_dreq(&rc, spi_get_dreq(SD_SPI, false));
+    dma_channel_configure(sd_dma_rx, &rc, &rx_sink, &spi_get_hw(SD_SPI)->dr, len, false);
+
+    dma_start_channel_mask((1u << sd_dma_tx) | (1u << sd_dma_rx));
+    dma_channel_wait_for_finish_blocking(sd_dma_rx);
+}
+
 // Deinitialize SD card hardware completely
 void sd_card_deinit(void) {
     sd_cs_deselect();
@@ -707,6 +773,136 @@ int sd_card_write_sector(uint32_t sector, const uint8_t *buffer) {
     return 0;
 }
 
+// Multi-block sector operations (CMD18/CMD25 + DMA)
+// One command covers the whole run of sectors and the 512-byte data phases
+// move over DMA, so sequential cluster reads/writes stream without the
+// per-block command overhead or CPU byte-banging of the single-block path.
+
+int sd_card_read_sectors(uint32_t sector, uint8_t *buffer, uint32_t count) {
+    if (!sd_initialized) {
+        printf("SD card not initialized\n");
+        return -1;
+    }
+
+    if (count == 0) return 0;
+    if (count == 1) return sd_card_read_sector(sector, buffer);
+
+    uint8_t token;
+    uint8_t dummy = 0xFF;
+
+    // Convert addressing: SDHC uses block numbers, SDSC uses byte addresses
+    uint32_t addr = is_sdhc ? sector : sector * 512;
+
+    // CMD18 = Read Multiple Blocks
+    uint8_t resp = sd_command(CMD18, addr, 0xFF);
+    if (resp != 0x00) {
+        printf("CMD18 failed: 0x%02X\n", resp);
+        sd_cs_deselect();
+        return -1;
+    }
+
+    for (uint32_t blk = 0; blk < count; blk++) {
+        // Wait for start token 0xFE
+        token = 0xFF;
+        for (int i = 0; i < 50000; i++) {
+            spi_read_blocking(SD_SPI, 0xFF, &token, 1);
+            if (token == 0xFE) break;
+        }
+
+        if (token != 0xFE) {
+            sd_cs_deselect();
+            return -1;
+        }
+
+        // Read 512 bytes of data via DMA
+        sd_spi_dma_read(buffer + (blk * 512), 512);
+
+        // Read CRC (required even though we don't verify it)
+        uint8_t crc[2];
+        spi_read_blocking(SD_SPI, 0xFF, crc, 2);
+    }
+
+    // CMD12 = Stop Transmission, then wait out the busy phase
+    sd_command(CMD12, 0, 0xFF);
+    spi_read_blocking(SD_SPI, 0xFF, &token, 1);  // Skip stuff byte
+    uint8_t busy = 0x00;
+    for (int i = 0; i < 65000; i++) {
+        spi_read_blocking(SD_SPI, 0xFF, &busy, 1);
+        if (busy == 0xFF) break;
+    }
+
+    sd_cs_deselect();
+    spi_write_blocking(SD_SPI, &dummy, 1);
+
+    return 0;
+}
+
+int sd_card_write_sectors(uint32_t sector, const uint8_t *buffer, uint32_t count) {
+    if (!sd_initialized) {
+        printf("SD card not initialized\n");
+        return -1;
+    }
+
+    if (count == 0) return 0;
+    if (count == 1) return sd_card_write_sector(sector, buffer);
+
+    uint8_t dummy = 0xFF;
+
+    // Convert addressing: SDHC uses block numbers, SDSC uses byte addresses
+    uint32_t addr = is_sdhc ? sector : sector * 512;
+
+    // CMD25 = Write Multiple Blocks
+    uint8_t resp = sd_command(CMD25, addr, 0xFF);
+    if (resp != 0x00) {
+        printf("CMD25 failed: 0x%02X\n", resp);
+        sd_cs_deselect();
+        return -1;
+    }
+    spi_write_blocking(SD_SPI, &dummy, 1);  // One byte gap before first block
+
+    for (uint32_t blk = 0; blk < count; blk++) {
+        // Multi-block start token
+        uint8_t token = 0xFC;
+        spi_write_blocking(SD_SPI, &token, 1);
+
+        // Send 512 bytes of data via DMA
+        sd_spi_dma_write(buffer + (blk * 512), 512);
+
+        // Send dummy CRC (2 bytes)
+        uint8_t crc[2] = {0xFF, 0xFF};
+        spi_write_blocking(SD_SPI, crc, 2);
+
+        // Read data response
+        spi_read_blocking(SD_SPI, 0xFF, &resp, 1);
+        if ((resp & 0x1F) != 0x05) {
+            printf("Write data response failed: 0x%02X (block %lu)\n", resp, blk);
+            sd_cs_deselect();
+            return -1;
+        }
+
+        // Wait for card to finish internal write operation
+        uint8_t busy;
+        for (int i = 0; i < 65000; i++) {
+            spi_read_blocking(SD_SPI, 0xFF, &busy, 1);
+            if (busy == 0xFF) break;
+        }
+    }
+
+    // Stop transmission token 0xFD, then final busy wait
+    uint8_t stop = 0xFD;
+    spi_write_blocking(SD_SPI, &stop, 1);
+    uint8_t busy = 0x00;
+    for (int i = 0; i < 65000; i++) {
+        spi_read_blocking(SD_SPI, 0xFF, &busy, 1);
+        if (busy == 0xFF) break;
+    }
+
+    sd_cs_deselect();
+    spi_write_blocking(SD_SPI, &dummy, 1);
+
+    return 0;
+}
+
 // High-level file operations using FAT32
 int sd_card_write_file(const char *filename, const uint8_t *data, size_t size) {
     if (!fat32_mounted) {
@@ -741,6 +937,16 @@ int sd_card_write_file(const char *filename, const uint8_t *data, size_t size) {
         return -1;
     }
     
+    // Pre-allocate contiguous space so the write is one sequential burst
+    // instead of a FAT walk-and-update per new cluster. Best effort: a
+    // full or fragmented card just writes the slow way.
+    if (size > 0) {
+        FRESULT exp = f_expand(&file, size, 1);
+        if (exp != FR_OK) {
+            printf("⚠️  Could not pre-allocate %zu bytes (err=%d), writing anyway\n", size, exp);
+        }
+    }
+
     // Write data
     printf("Writing %zu bytes...\n", size);
     res = f_write(&file, data, size, &bytes_written);
@@ -9,19 +9,74 @@
 
 // UDP State
 static struct udp_pcb *udp_pcb = NULL;
-static uint8_t *recv_buffer = NULL;
-static size_t recv_buffer_size = 0;
-static size_t recv_len = 0;
-static bool data_received = false;
 
-// Semaphore for signaling data arrival
+// Receive queue: ring of pbuf references filled by the lwIP callback and
+// drained by wifi_udp_receive(). The callback only stores the pbuf pointer
+// (no memcpy on the lwIP core), so back-to-back chunk arrivals during block
+// transfers are queued instead of silently dropped.
+#define UDP_RX_QUEUE_DEPTH 8
+
+static struct pbuf *rx_queue[UDP_RX_QUEUE_DEPTH];
+static volatile uint8_t rx_head = 0;  // Next slot to dequeue
+static volatile uint8_t rx_tail = 0;  // Next slot to enqueue
+static uint32_t rx_dropped = 0;       // Packets lost to a full queue
+
+// Semaphore for signaling data arrival (counts queued packets)
 static semaphore_t recv_sem;
 static bool sem_initialized = false;
 
+// Event semaphore: released on packet arrival and by wifi_udp_notify()
+// (e.g. from a GPIO ISR), so app loops can block until there is work
+// instead of poll-sleeping. Spurious wakeups are harmless - the waker
+// re-checks its work sources.
+static semaphore_t event_sem;
+static bool event_sem_initialized = false;
+
 // Mutex for protecting shared state
 static mutex_t recv_mutex;
 static bool mutex_initialized = false;
 
+static inline uint8_t rx_queue_next(uint8_t idx) {
+    return (uint8_t)((idx + 1) % UDP_RX_QUEUE_DEPTH);
+}
+
+// Transmit pool: preallocated PBUF_RAM pbufs reused for every send, so the
+// per-packet pbuf_alloc/memcpy/pbuf_free cycle disappears from the hot path.
+// A slot is reusable as soon as udp_sendto() returns (the cyw43 driver copies
+// the frame out synchronously). Callers that want to skip the payload copy
+// entirely can claim a slot, serialize straight into it, and send it.
+#define UDP_TX_POOL_SIZE 4
+#define UDP_TX_SLOT_BYTES 1200  // Covers a 1KB negotiated chunk + MQTT-SN headers
+
+static struct pbuf *tx_pool[UDP_TX_POOL_SIZE];
+static int tx_claimed = -1;     // Slot handed out via wifi_udp_tx_claim()
+
+// Get a free pool slot, allocating it on first use. Returns NULL when the
+// pool is exhausted (caller falls back to a one-off pbuf_alloc).
+static struct pbuf *tx_pool_get(int *idx_out) {
+    for (int i = 0; i < UDP_TX_POOL_SIZE; i++) {
+        if (i == tx_claimed) continue;
+
+        if (tx_pool[i] == NULL) {
+            tx_pool[i] = pbuf_alloc(PBUF_TRANSPORT, UDP_TX_SLOT_BYTES, PBUF_RAM);
+            if (tx_pool[i] == NULL) {
+                return NULL;
+            }
+        }
+        if (idx_out) *idx_out = i;
+        return tx_pool[i];
+    }
+    return NULL;
+}
+
+// Send a pool pbuf trimmed to len bytes, then restore its full capacity
+static int tx_pool_sendto(struct pbuf *p, size_t len, const ip_addr_t *dest_addr, uint16_t dest_port) {
+    p->len = p->tot_len = (u16_t)len;
+    err_t err = udp_sendto(udp_pcb, p, dest_addr, dest_port);
+    p->len = p->tot_len = UDP_TX_SLOT_BYTES;
+    return err;
+}
+
 // Callback for UDP receives
 static void udp_recv_callback(void *arg, struct udp_pcb *pcb, struct pbuf *p,
                                const ip_addr_t *addr, u16_t port) {
@@ -31,34 +86,58 @@ static void udp_recv_callback(void *arg, struct udp_pcb *pcb, struct pbuf *p,
         if (mutex_initialized){
             mutex_enter_blocking(&recv_mutex);
         }
-        
-        if (recv_buffer != NULL && !data_received) {
-            // Copy data up to the available buffer size
-            size_t copy_len = p->len < recv_buffer_size ? p->len : recv_buffer_size;
-            memcpy(recv_buffer, p->payload, copy_len);
-            // Update recv_len to the actual amount copied
-            recv_len = copy_len;
-            data_received = true;
+
+        uint8_t next_tail = rx_queue_next(rx_tail);
+        if (next_tail != rx_head) {
+            // Enqueue the pbuf reference as-is; ownership passes to the consumer
+            rx_queue[rx_tail] = p;
+            rx_tail = next_tail;
 
             // Signal that data is ready
             if (sem_initialized) {
                 sem_release(&recv_sem);
             }
+            if (event_sem_initialized) {
+                sem_release(&event_sem);  // Wake a blocked event loop
+            }
+        } else {
+            // Queue full - drop and count (NACK path recovers lost chunks)
+            rx_dropped++;
+            pbuf_free(p);
         }
 
         if (mutex_initialized) {
             mutex_exit(&recv_mutex);
         }
+    }
+}
+
+// Dequeue one pbuf, or NULL when the queue is empty. Caller owns the pbuf.
+static struct pbuf *rx_queue_pop(void) {
+    struct pbuf *p = NULL;
+
+    if (mutex_initialized) {
+        mutex_enter_blocking(&recv_mutex);
+    }
+
+    if (rx_head != rx_tail) {
+        p = rx_queue[rx_head];
+        rx_queue[rx_head] = NULL;
+        rx_head = rx_queue_next(rx_head);
+    }
 
-        pbuf_free(p);
+    if (mutex_initialized) {
+        mutex_exit(&recv_mutex);
     }
+
+    return p;
 }
 
 
 int wifi_udp_create(uint16_t local_port){
     // Initialize semaphore on first call
     if (!sem_initialized) {
-        sem_init(&recv_sem, 0, 1);  // Binary semaphore, initial count 0
+        sem_init(&recv_sem, 0, UDP_RX_QUEUE_DEPTH);  // Counts queued packets
         sem_initialized = true;
         // printf("[UDP] Semaphore initialized\n");
     }
@@ -70,6 +149,11 @@ int wifi_udp_create(uint16_t local_port){
         // printf("[UDP] Mutex initialized\n");
     }
 
+    if (!event_sem_initialized) {
+        sem_init(&event_sem, 0, UDP_RX_QUEUE_DEPTH);
+        event_sem_initialized = true;
+    }
+
     // Close existing PCB if open
     if (udp_pcb != NULL){
         printf("[INFO] Closing existing UDP sockets\n");
@@ -131,17 +215,26 @@ int wifi_udp_send(const char *dest_ip, uint16_t dest_port, const uint8_t *data,
             return WIFI_EINVAL;
         }
 
-        // Alloate packet buffer
-        struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
-        if (p == NULL){
-            printf("[UDP] Send Failed: Could not allocate pbuf (%zu bytes)\n", len);
-            return WIFI_ENOMEM;
-        }
+        err_t err;
+        struct pbuf *pool_p = (len <= UDP_TX_SLOT_BYTES) ? tx_pool_get(NULL) : NULL;
+
+        if (pool_p != NULL) {
+            // Fast path: copy into a preallocated pool pbuf, no alloc/free
+            memcpy(pool_p->payload, data, len);
+            err = tx_pool_sendto(pool_p, len, &dest_addr, dest_port);
+        } else {
+            // Oversized payload or exhausted pool: one-off allocation
+            struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
+            if (p == NULL){
+                printf("[UDP] Send Failed: Could not allocate pbuf (%zu bytes)\n", len);
+                return WIFI_ENOMEM;
+            }
 
-        memcpy(p->payload, data, len);
+            memcpy(p->payload, data, len);
 
-        err_t err = udp_sendto(udp_pcb, p, &dest_addr, dest_port);
-        pbuf_free(p);
+            err = udp_sendto(udp_pcb, p, &dest_addr, dest_port);
+            pbuf_free(p);
+        }
 
         if (err != ERR_OK){
             printf("[UDP] Send Failed: udp_sendto error %d\n", err);
@@ -162,87 +255,105 @@ int wifi_udp_send(const char *dest_ip, uint16_t dest_port, const uint8_t *data,
         return WIFI_OK;
 }
 
-int wifi_udp_receive(uint8_t *buffer, size_t max_len, uint32_t timeout_ms) {
-    // Treat all failures here as not connected
-    if (udp_pcb == NULL){
-        printf("[UDP] Received failed: socket not created\n");
+uint8_t *wifi_udp_tx_claim(size_t max_len){
+    if (max_len > UDP_TX_SLOT_BYTES || tx_claimed != -1){
+        return NULL;  // Too large for a slot, or a claim is already out
+    }
+
+    int idx = -1;
+    struct pbuf *p = tx_pool_get(&idx);
+    if (p == NULL){
+        return NULL;
+    }
+
+    tx_claimed = idx;
+    return (uint8_t *)p->payload;
+}
+
+int wifi_udp_send_claimed(const char *dest_ip, uint16_t dest_port, size_t len){
+    if (udp_pcb == NULL || tx_claimed == -1){
         return WIFI_ESOCKET;
     }
 
-    if (buffer == NULL || max_len == 0){
-        printf("[UDP] Received failed: Invalid Buffer\n");
+    if (dest_ip == NULL || len == 0 || len > UDP_TX_SLOT_BYTES || dest_port == 0){
         return WIFI_EINVAL;
     }
 
-    // Lock mutex to set up receive buffer
-    if (mutex_initialized) {
-        mutex_enter_blocking(&recv_mutex);
+    ip_addr_t dest_addr;
+    if (!ip4addr_aton(dest_ip, &dest_addr)){
+        printf("[UDP] Send Failed: Invalid IP Address '%s'\n", dest_ip);
+        return WIFI_EINVAL;
     }
 
-    // Set up receive buffer
-    recv_buffer = buffer;
-    recv_buffer_size = max_len;
-    recv_len = 0;
-    data_received = false;
+    struct pbuf *p = tx_pool[tx_claimed];
+    tx_claimed = -1;
 
-    if (mutex_initialized) {
-        mutex_exit(&recv_mutex);
+    err_t err = tx_pool_sendto(p, len, &dest_addr, dest_port);
+    if (err != ERR_OK){
+        printf("[UDP] Send Failed: udp_sendto error %d\n", err);
+        return (err == ERR_MEM || err == ERR_BUF) ? WIFI_ENOMEM : WIFI_ESOCKET;
     }
 
-    int result;
+    return WIFI_OK;
+}
 
-    if (timeout_ms == 0) {
-        // Non-blocking mode: Check if data is already available
-        if (mutex_initialized) {
-            mutex_enter_blocking(&recv_mutex);
-        }
+void wifi_udp_tx_release(void){
+    tx_claimed = -1;
+}
 
-        if (data_received) {
-            result = recv_len;
-            data_received = false;
-            printf("[UDP] Non-blocking receive: %d bytes\n", result);
-            
-        } else {
-            result = 0;
-        }
+int wifi_udp_receive(uint8_t *buffer, size_t max_len, uint32_t timeout_ms) {
+    // Treat all failures here as not connected
+    if (udp_pcb == NULL){
+        printf("[UDP] Received failed: socket not created\n");
+        return WIFI_ESOCKET;
+    }
 
-        recv_buffer = NULL;
+    if (buffer == NULL || max_len == 0){
+        printf("[UDP] Received failed: Invalid Buffer\n");
+        return WIFI_EINVAL;
+    }
 
-        if (mutex_initialized) {
-            mutex_exit(&recv_mutex);
+    struct pbuf *p = rx_queue_pop();
+
+    if (p == NULL && timeout_ms > 0) {
+        // Blocking mode: wait for the callback to enqueue a packet
+        if (sem_acquire_timeout_ms(&recv_sem, timeout_ms)) {
+            p = rx_queue_pop();
         }
-    } else {
-        // Blocking mode with timeout
-        // printf("[UDP] Waiting for data (timeout: %lu ms)...\n", timeout_ms);
-        // printf("In wifi_udp_receive BEFORE semaphore and mutex, data_recieved = %d\n", data_received);
+    }
 
-        // Wait on semaphore with timeout
-        bool acquired = sem_acquire_timeout_ms(&recv_sem, timeout_ms);
+    if (p == NULL) {
+        // Non-blocking returns 0 for "no data", blocking returns timeout
+        return (timeout_ms == 0) ? 0 : WIFI_ETIMEDOUT;
+    }
 
-        // Lock mutex to read result
-        if (mutex_initialized) {
-            mutex_enter_blocking(&recv_mutex);
-        }
+    // Single copy from the pbuf chain into the caller's buffer
+    size_t copy_len = (p->tot_len < max_len) ? p->tot_len : max_len;
+    pbuf_copy_partial(p, buffer, copy_len, 0);
+    pbuf_free(p);
 
-        // printf("In wifi_udp_receive AFTER semaphore and mutex, data_recieved = %d\n", data_received);
+    return (int)copy_len;
+}
 
-        if (acquired && data_received) {
-            result = recv_len;
-            data_received = false;
-            // printf("[UDP] Received %d bytes\n", result);
-        } else {
-            result = WIFI_ETIMEDOUT;
-            //printf("[UDP] Receive timeout (%lu ms)\n", timeout_ms);
-        }
-        
-        recv_buffer = NULL;
-        
-        if (mutex_initialized) {
-            mutex_exit(&recv_mutex);
-        }
+uint32_t wifi_udp_get_rx_dropped(void) {
+    return rx_dropped;
+}
+
+// Block until a packet arrives, wifi_udp_notify() fires, or timeout_ms
+// elapses. Returns true when woken by an event, false on timeout.
+bool wifi_udp_wait_event(uint32_t timeout_ms) {
+    if (!event_sem_initialized) {
+        sleep_ms(timeout_ms);  // No socket yet - behave like the old poll-sleep
+        return false;
     }
+    return sem_acquire_timeout_ms(&event_sem, timeout_ms);
+}
 
-    return result;
+// Wake anything blocked in wifi_udp_wait_event(). Safe from ISRs.
+void wifi_udp_notify(void) {
+    if (event_sem_initialized) {
+        sem_release(&event_sem);
+    }
 }
 
 
@@ -257,8 +368,22 @@ void wifi_udp_close(void){
 
         udp_remove(udp_pcb);
         udp_pcb = NULL;
-        recv_buffer = NULL;
-        data_received = false;
+
+        // Release any packets still queued
+        while (rx_head != rx_tail) {
+            pbuf_free(rx_queue[rx_head]);
+            rx_queue[rx_head] = NULL;
+            rx_head = rx_queue_next(rx_head);
+        }
+
+        // Release the transmit pool
+        tx_claimed = -1;
+        for (int i = 0; i < UDP_TX_POOL_SIZE; i++) {
+            if (tx_pool[i] != NULL) {
+                pbuf_free(tx_pool[i]);
+                tx_pool[i] = NULL;
+            }
+        }
 
         if (mutex_initialized) {
             mutex_exit(&recv_mutex);
@@ -9,6 +9,65 @@
 
 static simple_wifi_t wifi_state = {0};
 
+// ============================================================================
+// AP ASSOCIATION CACHE (retained RAM)
+// ============================================================================
+
+// BSSID and channel of the last AP we associated with, kept in a RAM
+// section the runtime never zeroes so it survives resets and watchdog
+// reboots (a real power loss clears it - the magic/checksum guard catches
+// the garbage). A directed join to the cached BSSID skips the full scan,
+// which is where most of the 15-30s rejoin time goes.
+typedef struct {
+    uint32_t magic;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t reserved;
+    uint32_t check;
+} wifi_ap_cache_t;
+
+#define AP_CACHE_MAGIC 0xA9C0FFEEu
+
+static wifi_ap_cache_t __uninitialized_ram(ap_cache);
+
+static uint32_t ap_cache_checksum(const wifi_ap_cache_t *c) {
+    uint32_t sum = c->magic ^ c->channel;
+    for (int i = 0; i < 6; i++) {
+        sum ^= (uint32_t)c->bssid[i] << ((i % 4) * 8);
+    }
+    return sum;
+}
+
+static bool ap_cache_valid(void) {
+    return ap_cache.magic == AP_CACHE_MAGIC &&
+           ap_cache.check == ap_cache_checksum(&ap_cache);
+}
+
+static void ap_cache_invalidate(void) {
+    ap_cache.magic = 0;
+}
+
+// Record the current association so the next (re)join can go direct
+static void ap_cache_store(void) {
+    if (cyw43_wifi_get_bssid(&cyw43_state, ap_cache.bssid) != 0) {
+        return;  // Leave whatever was cached before
+    }
+
+    uint8_t buf[4] = {0};
+    ap_cache.channel = 0;
+    if (cyw43_ioctl(&cyw43_state, CYW43_IOCTL_GET_CHANNEL, sizeof(buf), buf, CYW43_ITF_STA) == 0) {
+        ap_cache.channel = buf[0];
+    }
+
+    ap_cache.magic = AP_CACHE_MAGIC;
+    ap_cache.check = ap_cache_checksum(&ap_cache);
+
+    printf("[INFO] Cached AP %02X:%02X:%02X:%02X:%02X:%02X (channel %u) for fast rejoin\n",
+           ap_cache.bssid[0], ap_cache.bssid[1], ap_cache.bssid[2],
+           ap_cache.bssid[3], ap_cache.bssid[4], ap_cache.bssid[5],
+           ap_cache.channel);
+}
+
 // Initialize WiFi with credentials
 int wifi_init(const char *ssid, const char *password) {
     printf("\n=== Initializing WiFi ===\n");
@@ -31,6 +90,7 @@ int wifi_init(const char *ssid, const char *password) {
     wifi_state.last_reconnect_time = nil_time;
     wifi_state.reconnect_count = 0;
     wifi_state.disconnect_count = 0;
+    wifi_state.reconnect_backoff_ms = RECONNECT_BACKOFF_MIN_MS;
     
     printf("[INFO] WiFi initialized\n");
     printf("[INFO] SSID: %s\n", wifi_state.ssid);
@@ -109,12 +169,37 @@ int wifi_connect(void) {
         printf("[DEBUG] Password length=0\n");
     }
 
-    int result = cyw43_arch_wifi_connect_timeout_ms(
-        wifi_state.ssid, 
-        wifi_state.password, 
-        CYW43_AUTH_WPA2_AES_PSK, 
-        CONNECTION_TIMEOUT_MS
-    );
+    // Fast path: directed join to the cached BSSID (no scan). Falls back
+    // to the full scan-and-join below if the AP moved or the cache is stale.
+    int result = -1;
+    if (ap_cache_valid()) {
+        printf("[INFO] Directed join to cached AP %02X:%02X:%02X:%02X:%02X:%02X (channel %u)\n",
+               ap_cache.bssid[0], ap_cache.bssid[1], ap_cache.bssid[2],
+               ap_cache.bssid[3], ap_cache.bssid[4], ap_cache.bssid[5],
+               ap_cache.channel);
+
+        result = cyw43_arch_wifi_connect_bssid_timeout_ms(
+            wifi_state.ssid,
+            ap_cache.bssid,
+            wifi_state.password,
+            CYW43_AUTH_WPA2_AES_PSK,
+            DIRECTED_JOIN_TIMEOUT_MS
+        );
+
+        if (result != 0) {
+            printf("[INFO] Directed join failed (%d), falling back to full scan\n", result);
+            ap_cache_invalidate();
+        }
+    }
+
+    if (result != 0) {
+        result = cyw43_arch_wifi_connect_timeout_ms(
+            wifi_state.ssid,
+            wifi_state.password,
+            CYW43_AUTH_WPA2_AES_PSK,
+            CONNECTION_TIMEOUT_MS
+        );
+    }
 
     // calculate connection time
     absolute_time_t connect_end = get_absolute_time();
@@ -135,10 +220,14 @@ int wifi_connect(void) {
         }
 
         printf("[SUCCESS] ✓ WiFi, %s, connected in %lu ms\n", wifi_state.ssid, connection_time_ms);
-        
+
+        // Remember the AP for fast rejoin, and reset the retry backoff
+        ap_cache_store();
+        wifi_state.reconnect_backoff_ms = RECONNECT_BACKOFF_MIN_MS;
+
         // Get and display IP address
         wifi_print_network_info();
-        
+
         return 0;
     } else {
         // Wifi connection issue error
@@ -151,29 +240,34 @@ int wifi_connect(void) {
     }
 }
 
-// Auto-reconnect logic
+// Auto-reconnect logic: retries start fast (a rejoin to the cached BSSID
+// is cheap) and back off exponentially while the AP stays unreachable, so
+// a power-blip recovery takes well under two seconds but a dead AP is not
+// hammered.
 void wifi_auto_reconnect(void) {
     absolute_time_t now = get_absolute_time();
-    
-    // Check connection status periodically
-    if (absolute_time_diff_us(wifi_state.last_check_time, now) >= 
-        RECONNECT_CHECK_INTERVAL_MS * 1000) {
-        
-        wifi_state.last_check_time = now;
-        
-        if (!wifi_is_connected()) {
-            // Only attempt reconnect if enough time has passed
-            if (is_nil_time(wifi_state.last_reconnect_time) ||
-                absolute_time_diff_us(wifi_state.last_reconnect_time, now) >= 
-                RECONNECT_ATTEMPT_INTERVAL_MS * 1000) {
-                
-                wifi_state.last_reconnect_time = now;
-                wifi_state.reconnect_count++;
-                
-                printf("\n[INFO] Re-Connection Attempt #%lu\n", 
-                       wifi_state.reconnect_count);
-                
-                wifi_connect();
+
+    if (wifi_is_connected()) {
+        return;
+    }
+
+    // Only attempt reconnect once the current backoff interval has passed
+    if (is_nil_time(wifi_state.last_reconnect_time) ||
+        absolute_time_diff_us(wifi_state.last_reconnect_time, now) >=
+        (int64_t)wifi_state.reconnect_backoff_ms * 1000) {
+
+        wifi_state.last_reconnect_time = now;
+        wifi_state.reconnect_count++;
+
+        printf("\n[INFO] Re-Connection Attempt #%lu (next retry in %lums)\n",
+               wifi_state.reconnect_count, wifi_state.reconnect_backoff_ms);
+
+        if (wifi_connect() != 0) {
+            // Double the interval up to the old fixed 10s cadence
+            // (success resets it inside wifi_connect)
+            wifi_state.reconnect_backoff_ms *= 2;
+            if (wifi_state.reconnect_backoff_ms > RECONNECT_BACKOFF_MAX_MS) {
+                wifi_state.reconnect_backoff_ms = RECONNECT_BACKOFF_MAX_MS;
             }
         }
     }
@@ -13,6 +13,18 @@ int mqttsn_transport_send(const char *dest_ip, uint16_t dest_port, const uint8_t
     return wifi_udp_send(dest_ip, dest_port, data, len);
 }
 
+uint8_t *mqttsn_transport_tx_claim(size_t max_len){
+    return wifi_udp_tx_claim(max_len);
+}
+
+int mqttsn_transport_send_claimed(const char *dest_ip, uint16_t dest_port, size_t len){
+    return wifi_udp_send_claimed(dest_ip, dest_port, len);
+}
+
+void mqttsn_transport_tx_release(void){
+    wifi_udp_tx_release();
+}
+
 int mqttsn_transport_receive(uint8_t *buffer, size_t max_len, uint32_t timeout_ms){
     return wifi_udp_receive(buffer, max_len, timeout_ms);
 }
@@ -0,0 +1,131 @@
+// mqttsn_batch.c - small-payload publish batching
+// (see include/protocol/mqttsn/mqttsn_batch.h)
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "protocol/mqttsn/mqttsn_batch.h"
+#include "protocol/mqttsn/mqttsn_client.h"
+
+// One pending batch: telemetry in practice goes to a single topic, and a
+// topic change just flushes, so one buffer covers the fleet's usage
+// without a per-topic table.
+static struct {
+    char topic[32];
+    uint8_t buf[MQTTSN_BATCH_MAX_BYTES];
+    uint16_t used;              // Bytes filled (including the header)
+    uint8_t count;
+    uint32_t first_queued_ms;   // Deadline runs from the oldest entry
+    bool active;
+} batch = {0};
+
+int mqttsn_batch_flush(void) {
+    if (!batch.active) {
+        return 0;
+    }
+
+    mqttsn_batch_header_t *hdr = (mqttsn_batch_header_t *)batch.buf;
+    hdr->magic = MQTTSN_BATCH_MAGIC;
+    hdr->count = batch.count;
+
+    int rc = mqttsn_demo_publish_name(batch.topic, batch.buf, (int)batch.used);
+    if (rc == 0 && batch.count > 1) {
+        printf("[BATCH] ✓ %u readings in one PUBLISH (%u bytes)\n",
+               batch.count, batch.used);
+    }
+    batch.active = false;
+    batch.used = 0;
+    batch.count = 0;
+    return rc;
+}
+
+int mqttsn_batch_publish(const char *topicname, const uint8_t *payload, int payloadlen) {
+    if (topicname == NULL || payload == NULL || payloadlen <= 0) {
+        return -1;
+    }
+
+    // Too big to batch, or a topic name the fixed slot can't hold:
+    // drain what's pending and publish directly
+    if (payloadlen > 255 ||
+        (size_t)payloadlen + 1 > sizeof(batch.buf) - sizeof(mqttsn_batch_header_t) ||
+        strlen(topicname) >= sizeof(batch.topic)) {
+        int rc = mqttsn_batch_flush();
+        if (rc != 0) {
+            return rc;
+        }
+        return mqttsn_demo_publish_name(topicname, payload, payloadlen);
+    }
+
+    // Topic change or full buffer closes the pending batch first
+    if (batch.active &&
+        (strcmp(batch.topic, topicname) != 0 ||
+         (size_t)batch.used + 1 + (size_t)payloadlen > sizeof(batch.buf) ||
+         batch.count == 255)) {
+        int rc = mqttsn_batch_flush();
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    if (!batch.active) {
+        snprintf(batch.topic, sizeof(batch.topic), "%s", topicname);
+        batch.used = sizeof(mqttsn_batch_header_t);
+        batch.count = 0;
+        batch.first_queued_ms = to_ms_since_boot(get_absolute_time());
+        batch.active = true;
+    }
+
+    batch.buf[batch.used++] = (uint8_t)payloadlen;
+    memcpy(&batch.buf[batch.used], payload, (size_t)payloadlen);
+    batch.used += (uint16_t)payloadlen;
+    batch.count++;
+
+    return 0;
+}
+
+int mqttsn_batch_poll(void) {
+    if (batch.active &&
+        (to_ms_since_boot(get_absolute_time()) - batch.first_queued_ms)
+            >= MQTTSN_BATCH_DEADLINE_MS) {
+        return mqttsn_batch_flush();
+    }
+    return 0;
+}
+
+uint32_t mqttsn_batch_wait_ms(void) {
+    if (!batch.active) {
+        return UINT32_MAX;
+    }
+    uint32_t elapsed = to_ms_since_boot(get_absolute_time()) - batch.first_queued_ms;
+    return (elapsed < MQTTSN_BATCH_DEADLINE_MS)
+               ? (MQTTSN_BATCH_DEADLINE_MS - elapsed) : 0;
+}
+
+int mqttsn_batch_decode(const uint8_t *payload, int payloadlen,
+                        mqttsn_batch_entry_cb cb, void *user) {
+    if (payload == NULL || payloadlen < (int)sizeof(mqttsn_batch_header_t) ||
+        payload[0] != MQTTSN_BATCH_MAGIC) {
+        return 0;  // Not a batch - caller handles it as a plain message
+    }
+
+    int count = payload[1];
+    int pos = (int)sizeof(mqttsn_batch_header_t);
+    int decoded = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (pos >= payloadlen) {
+            return -1;  // Truncated
+        }
+        int entry_len = payload[pos++];
+        if (entry_len == 0 || pos + entry_len > payloadlen) {
+            return -1;  // Malformed entry
+        }
+        if (cb != NULL) {
+            cb(&payload[pos], entry_len, user);
+        }
+        pos += entry_len;
+        decoded++;
+    }
+
+    return decoded;
+}
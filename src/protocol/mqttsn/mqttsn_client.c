@@ -8,7 +8,10 @@
 #include <string.h>
 #include <stdbool.h>
 #include "pico/stdlib.h"
+#include "log.h"
 #include "protocol/mqttsn/mqttsn_adapter.h"
+#include "protocol/mqttsn/mqttsn_gateway.h"
+#include "protocol/mqttsn/mqttsn_dispatch.h"
 #include "config/network_config.h"
 #include "drivers/block_transfer.h"
 
@@ -22,12 +25,148 @@
 
 static bool mqttsn_initialized = false;
 static bool mqttsn_connected = false;
-static unsigned short mqttsn_registered_topicid = 0;  // For pico/test
-static unsigned short mqttsn_chunks_topicid = 0;      // For pico/chunks
-static unsigned short mqttsn_retransmit_topicid = 0;  // For pico/retransmit
 static unsigned short mqttsn_msg_id = 1;
 static int current_qos = 0;  // Default to QoS 0
 
+// Topic registry: maps topic names to gateway-assigned IDs. Open-addressed
+// hash table so the per-publish lookup is a hash + compare instead of a
+// strcmp chain, and new topics don't need new globals. Names must point to
+// static storage (string literals) - they are not copied.
+#define MQTTSN_TOPIC_TABLE_SIZE 16  // Power of two; we run ~a dozen topics max
+
+typedef struct {
+    const char *name;           // NULL = free slot
+    uint32_t hash;
+    unsigned short topic_id;    // 0 = not registered yet
+    unsigned short reg_msgid;   // MsgID of the in-flight REGISTER (0 = none)
+} mqttsn_topic_entry_t;
+
+static mqttsn_topic_entry_t mqttsn_topics[MQTTSN_TOPIC_TABLE_SIZE];
+
+// FNV-1a: cheap and good enough for a 16-slot table of short names
+static uint32_t mqttsn_topic_hash(const char *name) {
+    uint32_t h = 2166136261u;
+    while (*name) {
+        h ^= (uint8_t)*name++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Find the entry for a name, inserting a free slot on first use.
+// Returns NULL only if the table is full.
+static mqttsn_topic_entry_t *mqttsn_topic_entry(const char *name) {
+    uint32_t hash = mqttsn_topic_hash(name);
+    uint32_t idx = hash & (MQTTSN_TOPIC_TABLE_SIZE - 1);
+
+    for (int probe = 0; probe < MQTTSN_TOPIC_TABLE_SIZE; probe++) {
+        mqttsn_topic_entry_t *e = &mqttsn_topics[idx];
+        if (e->name == NULL) {
+            e->name = name;
+            e->hash = hash;
+            e->topic_id = 0;
+            e->reg_msgid = 0;
+            return e;
+        }
+        if (e->hash == hash && strcmp(e->name, name) == 0) {
+            return e;
+        }
+        idx = (idx + 1) & (MQTTSN_TOPIC_TABLE_SIZE - 1);
+    }
+    return NULL;
+}
+
+// Forget all gateway-assigned IDs (on disconnect they become invalid)
+static void mqttsn_topic_registry_reset(void) {
+    for (int i = 0; i < MQTTSN_TOPIC_TABLE_SIZE; i++) {
+        mqttsn_topics[i].topic_id = 0;
+        mqttsn_topics[i].reg_msgid = 0;
+    }
+}
+
+#ifdef HAVE_PAHO
+// Send a REGISTER for one entry without waiting for the REGACK
+static int mqttsn_topic_send_register(mqttsn_topic_entry_t *e) {
+    unsigned char buf[256];
+    MQTTSNString topic_string = MQTTSNString_initializer;
+    topic_string.cstring = (char*)e->name;
+    topic_string.lenstring.len = strlen(e->name);
+
+    if (mqttsn_msg_id == 0) mqttsn_msg_id = 1;
+    unsigned short msgid = mqttsn_msg_id++;
+
+    int len = MQTTSNSerialize_register(buf, sizeof(buf), 0, msgid, &topic_string);
+    if (len <= 0) {
+        printf("[MQTTSN] Failed to serialize REGISTER for '%s' (rc=%d)\n", e->name, len);
+        return -1;
+    }
+
+    int s = mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(), buf, len);
+    if (s != 0) {
+        printf("[MQTTSN] REGISTER send failed for '%s' (err=%d)\n", e->name, s);
+        return -2;
+    }
+
+    e->reg_msgid = msgid;
+    return 0;
+}
+
+// Match one REGACK against an in-flight REGISTER. Returns true if it
+// completed an entry (success or rejection).
+static bool mqttsn_topic_handle_regack(unsigned char *buf, int len) {
+    unsigned short topicid = 0, msgid = 0;
+    unsigned char rc = 0;
+    if (MQTTSNDeserialize_regack(&topicid, &msgid, &rc, buf, len) != 1) {
+        return false;
+    }
+
+    for (int i = 0; i < MQTTSN_TOPIC_TABLE_SIZE; i++) {
+        mqttsn_topic_entry_t *e = &mqttsn_topics[i];
+        if (e->name && e->reg_msgid != 0 && e->reg_msgid == msgid) {
+            e->reg_msgid = 0;
+            if (rc == MQTTSN_RC_ACCEPTED) {
+                e->topic_id = topicid;
+                printf("[MQTTSN] ✓ Topic '%s' registered (TopicID=%u)\n", e->name, topicid);
+            } else {
+                printf("[MQTTSN] ✗ Topic '%s' registration rejected (code=%d)\n", e->name, rc);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// Pipelined registration: fire a REGISTER for every unregistered entry,
+// then collect the REGACKs in one wait loop - one round trip total instead
+// of a blocking 5-second exchange per topic. Returns entries still pending.
+static int mqttsn_topic_register_pending(uint32_t timeout_ms) {
+    unsigned char buf[256];
+    int pending = 0;
+
+    for (int i = 0; i < MQTTSN_TOPIC_TABLE_SIZE; i++) {
+        mqttsn_topic_entry_t *e = &mqttsn_topics[i];
+        if (e->name && e->topic_id == 0) {
+            if (mqttsn_topic_send_register(e) == 0) pending++;
+        }
+    }
+    if (pending == 0) return 0;
+
+    uint32_t start = to_ms_since_boot(get_absolute_time());
+    while (pending > 0 &&
+           (to_ms_since_boot(get_absolute_time()) - start) < timeout_ms) {
+        int r = mqttsn_transport_receive(buf, sizeof(buf), 100);
+        if (r >= 2 && buf[1] == 0x0B) {  // REGACK
+            if (mqttsn_topic_handle_regack(buf, r)) pending--;
+        }
+    }
+
+    if (pending > 0) {
+        printf("[MQTTSN] ⚠️  %d topic registration(s) unacknowledged\n", pending);
+    }
+    return pending;
+}
+#endif // HAVE_PAHO
+
 // Get current QoS level
 int mqttsn_get_qos(void) {
     return current_qos;
@@ -37,9 +176,10 @@ int mqttsn_get_qos(void) {
 void mqttsn_set_qos(int qos) {
     if (qos >= 0 && qos <= 2) {
         current_qos = qos;
-        printf("[MQTTSN] QoS level set to %d\n", qos);
+        // TRACE: the retransmit path toggles QoS around every resent chunk
+        LOG_TRACE("[MQTTSN] QoS level set to %d\n", qos);
     } else {
-        printf("[MQTTSN] Invalid QoS level %d (must be 0, 1, or 2)\n", qos);
+        LOG_WARN("[MQTTSN] Invalid QoS level %d (must be 0, 1, or 2)\n", qos);
     }
 }
 
@@ -67,13 +207,15 @@ int mqttsn_demo_init(uint16_t local_port, const char *client_id){
     }
     
     printf("[MQTTSN] Sending CONNECT (%d bytes)...\n", len);
-    printf("[DEBUG] CONNECT packet: ");
-    for(int i = 0; i < len; i++) {
-        printf("%02x ", buf[i]);
+    if (LOG_ENABLED(LOG_LEVEL_TRACE)) {
+        LOG_TRACE("[DEBUG] CONNECT packet: ");
+        for(int i = 0; i < len; i++) {
+            LOG_TRACE("%02x ", buf[i]);
+        }
+        LOG_TRACE("\n");
     }
-    printf("\n");
 
-    int s = mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, buf, len);
+    int s = mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(), buf, len);
     if (s != 0) {
         printf("[MQTTSN] CONNECT send failed (err=%d)\n", s);
         return -2;
@@ -83,11 +225,13 @@ int mqttsn_demo_init(uint16_t local_port, const char *client_id){
     printf("[MQTTSN] Waiting for CONNACK...\n");
     int r = mqttsn_transport_receive(buf, sizeof(buf), 5000);
     if (r > 0) {
-        printf("[DEBUG] Received %d bytes: ", r);
-        for(int i = 0; i < r && i < 20; i++) {
-            printf("%02x ", buf[i]);
+        if (LOG_ENABLED(LOG_LEVEL_TRACE)) {
+            LOG_TRACE("[DEBUG] Received %d bytes: ", r);
+            for(int i = 0; i < r && i < 20; i++) {
+                LOG_TRACE("%02x ", buf[i]);
+            }
+            LOG_TRACE("\n");
         }
-        printf("\n");
 
         int connack_rc = -1;
         int d = MQTTSNDeserialize_connack(&connack_rc, buf, r);
@@ -108,128 +252,21 @@ int mqttsn_demo_init(uint16_t local_port, const char *client_id){
         return -5;
     }
 
-    // Step 3: Register the default topic
-    const char *default_topic = "pico/test";
-    printf("[MQTTSN] Registering topic '%s'...\n", default_topic);
-    
-    unsigned short topicid = 0;  // 0 means we want the gateway to assign an ID
-    
-    // MQTTSNSerialize_register(buf, buflen, topicid, msgid, topicname)
-    // The last parameter should be MQTTSNString, not MQTTSN_topicid
-    MQTTSNString topic_string = MQTTSNString_initializer;
-    topic_string.cstring = (char*)default_topic;
-    topic_string.lenstring.len = strlen(default_topic);
-    
-    len = MQTTSNSerialize_register(buf, sizeof(buf), topicid, mqttsn_msg_id, &topic_string);
-    if (len <= 0) {
-        printf("[MQTTSN] Failed to serialize REGISTER (rc=%d)\n", len);
-        printf("[DEBUG] Buffer size: %zu, topic length: %zu, msgid: %u\n", 
-               sizeof(buf), strlen(default_topic), mqttsn_msg_id);
-        return -6;
-    }
-
-    printf("[DEBUG] REGISTER packet (%d bytes): ", len);
-    for(int i = 0; i < len; i++) {
-        printf("%02x ", buf[i]);
-    }
-    printf("\n");
-
-    s = mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, buf, len);
-    if (s != 0) {
-        printf("[MQTTSN] REGISTER send failed (err=%d)\n", s);
-        return -7;
-    }
-
-    // Step 4: Wait for REGACK
-    printf("[MQTTSN] Waiting for REGACK...\n");
-    r = mqttsn_transport_receive(buf, sizeof(buf), 5000);
-    if (r > 0) {
-        printf("[DEBUG] Received %d bytes: ", r);
-        for(int i = 0; i < r && i < 20; i++) {
-            printf("%02x ", buf[i]);
-        }
-        printf("\n");
-
-        unsigned short returned_topicid = 0;
-        unsigned short returned_msgid = 0;
-        unsigned char return_code = 0;
-
-        int d = MQTTSNDeserialize_regack(&returned_topicid, &returned_msgid, &return_code, buf, r);
-        if (d == 1) {
-            if (return_code == MQTTSN_RC_ACCEPTED) {
-                mqttsn_registered_topicid = returned_topicid;
-                printf("[MQTTSN] ✓ Topic registered (TopicID=%u, MsgID=%u)\n", 
-                       returned_topicid, returned_msgid);
-            } else {
-                printf("[MQTTSN] ✗ Topic registration rejected (code=%d)\n", return_code);
-                return -8;
-            }
-        } else {
-            printf("[MQTTSN] ✗ Failed to parse REGACK\n");
-            return -9;
-        }
-    } else {
-        printf("[MQTTSN] ✗ REGACK not received (rc=%d)\n", r);
-        return -10;
-    }
-
-    mqttsn_msg_id++;
-    
-    // Also register pico/chunks topic for block transfers
-    printf("[MQTTSN] Registering topic 'pico/chunks' for block transfers...\n");
-    const char *chunks_topic = "pico/chunks";
-    MQTTSNString chunks_topic_string = MQTTSNString_initializer;
-    chunks_topic_string.cstring = (char*)chunks_topic;
-    chunks_topic_string.lenstring.len = strlen(chunks_topic);
-    
-    len = MQTTSNSerialize_register(buf, sizeof(buf), 0, mqttsn_msg_id, &chunks_topic_string);
-    if (len > 0) {
-        s = mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, buf, len);
-        if (s == 0) {
-            r = mqttsn_transport_receive(buf, sizeof(buf), 5000);
-            if (r > 0) {
-                unsigned short chunks_topicid = 0;
-                unsigned short chunks_msgid = 0;
-                unsigned char chunks_rc = 0;
-                if (MQTTSNDeserialize_regack(&chunks_topicid, &chunks_msgid, &chunks_rc, buf, r) == 1) {
-                    if (chunks_rc == MQTTSN_RC_ACCEPTED) {
-                        mqttsn_chunks_topicid = chunks_topicid;
-                        printf("[MQTTSN] ✓ Topic 'pico/chunks' registered (TopicID=%u)\n", chunks_topicid);
-                        mqttsn_msg_id++;
-                    } else {
-                        printf("[MQTTSN] ⚠ Topic 'pico/chunks' registration rejected (code=%d)\n", chunks_rc);
-                    }
-                }
-            }
-        }
-    }
-    
-    // Also register pico/retransmit topic for retransmission requests
-    printf("[MQTTSN] Registering topic 'pico/retransmit' for retransmission...\n");
-    const char *retx_topic = "pico/retransmit";
-    MQTTSNString retx_topic_string = MQTTSNString_initializer;
-    retx_topic_string.cstring = (char*)retx_topic;
-    retx_topic_string.lenstring.len = strlen(retx_topic);
-    
-    len = MQTTSNSerialize_register(buf, sizeof(buf), 0, mqttsn_msg_id, &retx_topic_string);
-    if (len > 0) {
-        s = mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, buf, len);
-        if (s == 0) {
-            r = mqttsn_transport_receive(buf, sizeof(buf), 5000);
-            if (r > 0) {
-                unsigned short retx_topicid = 0;
-                unsigned short retx_msgid = 0;
-                unsigned char retx_rc = 0;
-                if (MQTTSNDeserialize_regack(&retx_topicid, &retx_msgid, &retx_rc, buf, r) == 1) {
-                    if (retx_rc == MQTTSN_RC_ACCEPTED) {
-                        mqttsn_retransmit_topicid = retx_topicid;
-                        printf("[MQTTSN] ✓ Topic 'pico/retransmit' registered (TopicID=%u)\n", retx_topicid);
-                        mqttsn_msg_id++;
-                    } else {
-                        printf("[MQTTSN] ⚠ Topic 'pico/retransmit' registration rejected (code=%d)\n", retx_rc);
-                    }
-                }
-            }
+    // Step 3: Register the standard topics. The REGISTERs are pipelined -
+    // all of them go out back-to-back and the REGACKs are collected in one
+    // wait loop, so startup costs one round trip instead of one blocking
+    // 5-second exchange per topic.
+    mqttsn_topic_entry("pico/test");
+    mqttsn_topic_entry("pico/chunks");
+    mqttsn_topic_entry("pico/retransmit");
+
+    printf("[MQTTSN] Registering standard topics (pipelined)...\n");
+    if (mqttsn_topic_register_pending(5000) > 0) {
+        // pico/test is required; the others retry lazily on first use
+        mqttsn_topic_entry_t *e = mqttsn_topic_entry("pico/test");
+        if (e == NULL || e->topic_id == 0) {
+            printf("[MQTTSN] ✗ Topic registration failed\n");
+            return -6;
         }
     }
 #else
@@ -250,11 +287,11 @@ int mqttsn_demo_send_test(const char *payload){
 
     size_t len = strlen(payload);
     uint32_t t0 = mqttsn_get_time_ms();
-    int rc = mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, (const uint8_t*)payload, len);
+    int rc = mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(), (const uint8_t*)payload, len);
     uint32_t t1 = mqttsn_get_time_ms();
 
     if (rc == 0){
-        printf("[MQTTSN] Sent %zu bytes to %s:%d (send_ms=%lums)\n", len, MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, (unsigned long)(t1 - t0));
+        printf("[MQTTSN] Sent %zu bytes to %s:%d (send_ms=%lums)\n", len, mqttsn_gateway_ip(), mqttsn_gateway_port(), (unsigned long)(t1 - t0));
         return 0;
     } else {
         printf("[MQTTSN] Send failed (err=%d)\n", rc);
@@ -269,6 +306,21 @@ int mqttsn_demo_receive(uint8_t *buffer, size_t max_len, uint32_t timeout_ms){
 }
 
 #ifdef HAVE_PAHO
+// Map a topic name to the gateway-assigned topic ID via the registry.
+// Topics that missed registration at startup are registered lazily here.
+static unsigned short mqttsn_topicid_for_name(const char *topicname) {
+    mqttsn_topic_entry_t *e = mqttsn_topic_entry(topicname);
+    if (e == NULL) {
+        printf("[MQTTSN] ✗ Topic table full ('%s')\n", topicname);
+        return 0;
+    }
+
+    if (e->topic_id == 0 && mqttsn_connected) {
+        mqttsn_topic_register_pending(2000);
+    }
+    return e->topic_id;
+}
+
 // Subscribe to a topic name. Returns topic id (>0) on success, or negative on error.
 int mqttsn_demo_subscribe(const char *topicname, unsigned short packetid, unsigned short *out_topicid){
     if (!mqttsn_initialized) return -1;
@@ -280,7 +332,7 @@ int mqttsn_demo_subscribe(const char *topicname, unsigned short packetid, unsign
 
     int len = MQTTSNSerialize_subscribe(buf, sizeof(buf), 0, 0, packetid, &topic);
     if (len <= 0) return -2;
-    int s = mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, buf, len);
+    int s = mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(), buf, len);
     if (s != 0) return -3;
 
     // Wait for SUBACK
@@ -313,76 +365,100 @@ int mqttsn_demo_publish_name(const char *topicname, const uint8_t *payload, int
         return -2;
     }
 
-    // Print payload
-    printf("[PUBLISHER] Payload (%d bytes): %.*s\n", payloadlen, payloadlen, (const char*)payload);
-    
-    // Select appropriate topic ID based on topic name
-    unsigned short topic_id_to_use = 0;
-    if (strcmp(topicname, "pico/chunks") == 0) {
-        topic_id_to_use = mqttsn_chunks_topicid;
-    } else if (strcmp(topicname, "pico/retransmit") == 0) {
-        topic_id_to_use = mqttsn_retransmit_topicid;
-    } else if (strcmp(topicname, "pico/test") == 0 || strcmp(topicname, "pico/block") == 0) {
-        topic_id_to_use = mqttsn_registered_topicid;
-    } else {
-        // Default to registered topic ID
-        topic_id_to_use = mqttsn_registered_topicid;
+#ifdef HAVE_PAHO
+    // QoS 2 runs through the windowed handshake state machine (see below);
+    // a standalone publish just fills a slot and drains the window, which
+    // replaces the old nested PUBREC/PUBREL/PUBCOMP wait loops here.
+    if (current_qos == 2) {
+        int rc = mqttsn_publish_window_send(topicname, payload, payloadlen);
+        while (rc == MQTTSN_EWINDOWFULL) {
+            mqttsn_publish_window_poll(20);
+            rc = mqttsn_publish_window_send(topicname, payload, payloadlen);
+        }
+        if (rc != 0) return rc;
+        return (mqttsn_publish_window_flush(15000) == 0) ? 0 : -11;
     }
-    
+#endif
+
+    // Payload dump is TRACE-only: formatting it per chunk costs more UART
+    // time than the chunk itself takes to send
+    LOG_TRACE("[PUBLISHER] Payload (%d bytes): %.*s\n", payloadlen, payloadlen, (const char*)payload);
+
+    // Select appropriate topic ID based on topic name
+    unsigned short topic_id_to_use = mqttsn_topicid_for_name(topicname);
+
     if (topic_id_to_use == 0) {
         printf("[MQTTSN] ✗ Cannot publish to '%s' - topic not registered\n", topicname);
         return -3;
     }
 
-    unsigned char buf[512];
+    unsigned char buf[MQTTSN_MAX_PACKET];
     MQTTSN_topicid topic;
-    
-    topic.type = MQTTSN_TOPIC_TYPE_NORMAL; 
+
+    topic.type = MQTTSN_TOPIC_TYPE_NORMAL;
     topic.data.id = topic_id_to_use;
 
     // For QoS 0, MsgId = 0; for QoS 1 and 2, use sequential message ID
     unsigned short msgid = (current_qos == 0) ? 0 : mqttsn_msg_id;
 
-    int len = MQTTSNSerialize_publish(buf, sizeof(buf), 
+    // For QoS 0 (the chunk hot path) serialize straight into a claimed
+    // transmit buffer so the payload is copied once, not twice. QoS 1/2
+    // keep the stack buffer because it is reused for the ack exchange.
+    unsigned char *pktbuf = buf;
+    bool tx_claimed = false;
+    if (current_qos == 0) {
+        uint8_t *slot = mqttsn_transport_tx_claim(sizeof(buf));
+        if (slot != NULL) {
+            pktbuf = slot;
+            tx_claimed = true;
+        }
+    }
+
+    int len = MQTTSNSerialize_publish(pktbuf, sizeof(buf),
                                        0,           // dup = 0
                                        current_qos, // qos = current QoS level
                                        0,           // retained = 0
-                                       msgid, 
-                                       topic, 
-                                       (unsigned char*)payload, 
+                                       msgid,
+                                       topic,
+                                       (unsigned char*)payload,
                                        payloadlen);
     if (len <= 0) {
         printf("[MQTTSN] Failed to serialize PUBLISH (rc=%d)\n", len);
+        if (tx_claimed) mqttsn_transport_tx_release();
         return -4;
     }
 
-    printf("[DEBUG] PUBLISH packet (%d bytes, QoS=%d): ", len, current_qos);
-    for(int i = 0; i < len && i < 30; i++) {
-        printf("%02x ", buf[i]);
+    if (LOG_ENABLED(LOG_LEVEL_TRACE)) {
+        LOG_TRACE("[DEBUG] PUBLISH packet (%d bytes, QoS=%d): ", len, current_qos);
+        for(int i = 0; i < len && i < 30; i++) {
+            LOG_TRACE("%02x ", pktbuf[i]);
+        }
+        LOG_TRACE("...\n");
     }
-    printf("...\n");
 
-    int s = mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, buf, len);
+    int s = tx_claimed
+        ? mqttsn_transport_send_claimed(mqttsn_gateway_ip(), mqttsn_gateway_port(), len)
+        : mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(), pktbuf, len);
     if (s != 0) {
         printf("[MQTTSN] PUBLISH send failed (err=%d)\n", s);
         return -5;
     }
-    
+
     if (current_qos == 0) {
         // QoS 0: Fire and forget - no acknowledgment, returns success immediately
         // WARNING: This does NOT guarantee delivery - packets may be lost
-        printf("[MQTTSN] ✓ PUBLISH sent (QoS 0, no ACK) to '%s' (TopicID=%u, len=%d)\n", 
+        LOG_TRACE("[MQTTSN] ✓ PUBLISH sent (QoS 0, no ACK) to '%s' (TopicID=%u, len=%d)\n",
                topicname, topic_id_to_use, payloadlen);
         return 0;  // QoS 0 returns immediately without waiting
     }
-    
-    printf("[MQTTSN] ✓ PUBLISH sent to '%s' (TopicID=%u, MsgID=%u, QoS=%d, len=%d)\n", 
+
+    LOG_TRACE("[MQTTSN] ✓ PUBLISH sent to '%s' (TopicID=%u, MsgID=%u, QoS=%d, len=%d)\n",
            topicname, topic_id_to_use, msgid, current_qos, payloadlen);
-    
+
     // Wait for acknowledgment for QoS 1 and 2
     if (current_qos == 1) {
         // Wait for PUBACK, but process other messages too
-        printf("[MQTTSN] Waiting for PUBACK (QoS 1)...\n");
+        LOG_TRACE("[MQTTSN] Waiting for PUBACK (QoS 1)...\n");
         bool puback_received = false;
         uint32_t wait_start = to_ms_since_boot(get_absolute_time());
         
@@ -392,12 +468,14 @@ int mqttsn_demo_publish_name(const char *topicname, const uint8_t *payload, int
                 continue;  // No message, keep waiting
             }
             
-            printf("[DEBUG] Received %d bytes: ", r);
-            for(int i = 0; i < r && i < 20; i++) {
-                printf("%02x ", buf[i]);
+            if (LOG_ENABLED(LOG_LEVEL_TRACE)) {
+                LOG_TRACE("[DEBUG] Received %d bytes: ", r);
+                for(int i = 0; i < r && i < 20; i++) {
+                    LOG_TRACE("%02x ", buf[i]);
+                }
+                LOG_TRACE("\n");
             }
-            printf("\n");
-            
+
             if (r < 2) continue;
             uint8_t msg_type = buf[1];
             
@@ -408,7 +486,7 @@ int mqttsn_demo_publish_name(const char *topicname, const uint8_t *payload, int
                 unsigned char return_code = buf[6];
                 
                 if (return_code == 0x00) {
-                    printf("[MQTTSN] ✓ PUBACK received (TopicID=%u, MsgID=%u)\n", 
+                    LOG_TRACE("[MQTTSN] ✓ PUBACK received (TopicID=%u, MsgID=%u)\n",
                            ack_topicid, ack_msgid);
                     puback_received = true;
                 } else {
@@ -432,16 +510,20 @@ int mqttsn_demo_publish_name(const char *topicname, const uint8_t *payload, int
                     printf("[MQTTSN] PUBLISH decoded: TopicID=%u, QoS=%d, PayloadLen=%d\n",
                            topic.data.id, qos, payloadlen_recv);
                     
-                    // Check if this is a NACK request
-                    if (payloadlen_recv >= 5 && strncmp((char*)payload_ptr, "NACK:", 5) == 0) {
+                    // Check if this is a retransmit request (binary SACK or
+                    // legacy ASCII NACK)
+                    if (payloadlen_recv >= 1 && payload_ptr[0] == BLOCK_SACK_MAGIC) {
+                        printf("[PUBLISHER] 📩 SACK request during publish wait!\n");
+                        block_transfer_handle_retransmit_binary(payload_ptr, payloadlen_recv);
+                    } else if (payloadlen_recv >= 5 && strncmp((char*)payload_ptr, "NACK:", 5) == 0) {
                         printf("[PUBLISHER] 📩 NACK request during publish wait!\n");
                         printf("[PUBLISHER] Payload: %.*s\n", payloadlen_recv, payload_ptr);
-                        
+
                         char request_msg[256];
                         int copy_len = (payloadlen_recv < 255) ? payloadlen_recv : 255;
                         memcpy(request_msg, payload_ptr, copy_len);
                         request_msg[copy_len] = '\0';
-                        
+
                         block_transfer_handle_retransmit_request(request_msg);
                     }
                 }
@@ -457,82 +539,294 @@ int mqttsn_demo_publish_name(const char *topicname, const uint8_t *payload, int
         }
         
         mqttsn_msg_id++;  // Increment only after acknowledgment
-        
-    } else if (current_qos == 2) {
-        // QoS 2: Wait for PUBREC (may need to skip PINGRESP and other messages)
-        printf("[MQTTSN] Waiting for PUBREC (QoS 2)...\n");
-        bool pubrec_received = false;
-        unsigned short rec_msgid = 0;
-        uint32_t start_time = to_ms_since_boot(get_absolute_time());
-        
-        while (!pubrec_received && (to_ms_since_boot(get_absolute_time()) - start_time) < 5000) {
-            int r = mqttsn_transport_receive(buf, sizeof(buf), 1000);
-            if (r > 0) {
-                uint8_t msg_type = (r >= 2) ? buf[1] : 0;
-                
-                // PUBREC format: [Length][0x0F][MsgId MSB][MsgId LSB]
-                if (r >= 4 && msg_type == 0x0F) {  // 0x0F = PUBREC
-                    rec_msgid = (buf[2] << 8) | buf[3];
-                    printf("[MQTTSN] ✓ PUBREC received (MsgID=%u)\n", rec_msgid);
-                    pubrec_received = true;
-                } else if (msg_type == 0x18) {
-                    // Skip PINGRESP
-                    continue;
-                } else {
-                    printf("[MQTTSN] Skipping message type 0x%02X while waiting for PUBREC\n", msg_type);
+    }
+    // For QoS 0, no acknowledgment needed, message ID stays 0
+    // (QoS 2 was delegated to the windowed state machine above)
+
+    return 0;
+}
+
+// Windowed publish engine (QoS 1 and 2)
+// Keeps up to MQTTSN_PUBLISH_WINDOW PUBLISHes in flight at once and completes
+// acks out of order, so block transfers are bounded by the link instead of
+// one stop-and-wait round trip per chunk. Each slot keeps the serialized
+// packet so an unacknowledged message can be resent with the DUP flag set.
+// QoS 2 slots walk the exactly-once handshake as a per-slot state machine
+// (PUBREC -> PUBREL -> PUBCOMP) driven from the poll path, so several
+// msgids progress through the handshake concurrently instead of each one
+// blocking for 2+ RTTs.
+
+#define MQTTSN_WINDOW_ACK_TIMEOUT_MS 1000   // Resend if no ack within this
+#define MQTTSN_WINDOW_MAX_RETRIES 3         // Then give up (NACK path recovers)
+
+// Per-slot handshake stage
+enum {
+    MQTTSN_SLOT_WAIT_PUBACK = 0,    // QoS 1: one ack completes the slot
+    MQTTSN_SLOT_WAIT_PUBREC,        // QoS 2: PUBLISH sent
+    MQTTSN_SLOT_WAIT_PUBCOMP,       // QoS 2: PUBREL sent
+};
+
+typedef struct {
+    bool in_use;
+    uint8_t state;
+    unsigned short msgid;
+    uint32_t sent_ms;
+    uint8_t retries;
+    int pkt_len;
+    unsigned char pkt[MQTTSN_MAX_PACKET];  // Serialized PUBLISH for DUP resend
+} mqttsn_inflight_t;
+
+static mqttsn_inflight_t mqttsn_inflight[MQTTSN_PUBLISH_WINDOW];
+
+// Delivery feedback for the pacing controller in block_transfer.c
+static uint32_t window_resends = 0;   // PUBLISHes resent after ack timeout
+static uint32_t window_srtt_ms = 0;   // Smoothed PUBACK RTT (EWMA, alpha=1/8)
+
+uint32_t mqttsn_publish_window_resends(void) {
+    return window_resends;
+}
+
+uint32_t mqttsn_publish_window_srtt_ms(void) {
+    return window_srtt_ms;
+}
+
+int mqttsn_publish_window_outstanding(void) {
+    int count = 0;
+    for (int i = 0; i < MQTTSN_PUBLISH_WINDOW; i++) {
+        if (mqttsn_inflight[i].in_use) count++;
+    }
+    return count;
+}
+
+int mqttsn_publish_window_send(const char *topicname, const uint8_t *payload, int payloadlen) {
+    if (!mqttsn_initialized || !mqttsn_connected) {
+        return -1;
+    }
+
+    // QoS 0 has no acknowledgment to track; QoS 1 and 2 both go through
+    // the window, with QoS 2 slots walking the full handshake.
+    if (current_qos == 0) {
+        return mqttsn_demo_publish_name(topicname, payload, payloadlen);
+    }
+
+    // Find a free slot
+    mqttsn_inflight_t *slot = NULL;
+    for (int i = 0; i < MQTTSN_PUBLISH_WINDOW; i++) {
+        if (!mqttsn_inflight[i].in_use) {
+            slot = &mqttsn_inflight[i];
+            break;
+        }
+    }
+    if (slot == NULL) {
+        return MQTTSN_EWINDOWFULL;  // Caller should poll acks and retry
+    }
+
+    unsigned short topic_id_to_use = mqttsn_topicid_for_name(topicname);
+    if (topic_id_to_use == 0) {
+        printf("[MQTTSN] ✗ Cannot publish to '%s' - topic not registered\n", topicname);
+        return -3;
+    }
+
+    MQTTSN_topicid topic;
+    topic.type = MQTTSN_TOPIC_TYPE_NORMAL;
+    topic.data.id = topic_id_to_use;
+
+    // MsgID 0 is reserved for QoS 0, skip it on wrap
+    if (mqttsn_msg_id == 0) mqttsn_msg_id = 1;
+    unsigned short msgid = mqttsn_msg_id++;
+
+    int len = MQTTSNSerialize_publish(slot->pkt, sizeof(slot->pkt),
+                                      0, current_qos, 0, msgid, topic,
+                                      (unsigned char*)payload, payloadlen);
+    if (len <= 0) {
+        printf("[MQTTSN] Failed to serialize PUBLISH (rc=%d)\n", len);
+        return -4;
+    }
+
+    int s = mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(), slot->pkt, len);
+    if (s != 0) {
+        printf("[MQTTSN] PUBLISH send failed (err=%d)\n", s);
+        return -5;
+    }
+
+    slot->in_use = true;
+    slot->state = (current_qos == 2) ? MQTTSN_SLOT_WAIT_PUBREC : MQTTSN_SLOT_WAIT_PUBACK;
+    slot->msgid = msgid;
+    slot->sent_ms = to_ms_since_boot(get_absolute_time());
+    slot->retries = 0;
+    slot->pkt_len = len;
+    return 0;
+}
+
+// Advance a QoS 2 slot: send (or resend) its PUBREL and restart the timer
+static void mqttsn_slot_send_pubrel(mqttsn_inflight_t *slot) {
+    unsigned char pubrel[4];
+    pubrel[0] = 4;
+    pubrel[1] = 0x10;    // PUBREL
+    pubrel[2] = (slot->msgid >> 8);
+    pubrel[3] = (slot->msgid & 0xFF);
+
+    mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(), pubrel, sizeof(pubrel));
+    slot->state = MQTTSN_SLOT_WAIT_PUBCOMP;
+    slot->sent_ms = to_ms_since_boot(get_absolute_time());
+}
+
+// Process incoming acks and resend timed-out slots. Returns the number of
+// messages completed this call (>= 0). timeout_ms = 0 polls without blocking.
+int mqttsn_publish_window_poll(uint32_t timeout_ms) {
+    unsigned char buf[MQTTSN_MAX_PACKET];
+    int completed = 0;
+
+    int r = mqttsn_transport_receive(buf, sizeof(buf), timeout_ms);
+    if (r >= 2) {
+        uint8_t msg_type = buf[1];
+
+        if (r >= 7 && msg_type == 0x0D) {  // PUBACK
+            unsigned short ack_msgid = (buf[4] << 8) | buf[5];
+            unsigned char return_code = buf[6];
+
+            for (int i = 0; i < MQTTSN_PUBLISH_WINDOW; i++) {
+                if (mqttsn_inflight[i].in_use && mqttsn_inflight[i].msgid == ack_msgid &&
+                    mqttsn_inflight[i].state == MQTTSN_SLOT_WAIT_PUBACK) {
+                    if (return_code != 0x00) {
+                        printf("[MQTTSN] ✗ PUBACK with error code=%d (MsgID=%u)\n",
+                               return_code, ack_msgid);
+                    }
+                    // Update smoothed RTT from first-transmission acks only
+                    // (a retransmitted slot's timing is ambiguous)
+                    if (mqttsn_inflight[i].retries == 0) {
+                        uint32_t rtt = to_ms_since_boot(get_absolute_time())
+                                       - mqttsn_inflight[i].sent_ms;
+                        window_srtt_ms = (window_srtt_ms == 0)
+                            ? rtt
+                            : (7 * window_srtt_ms + rtt) / 8;
+                    }
+                    mqttsn_inflight[i].in_use = false;
+                    completed++;
+                    break;
                 }
             }
-        }
-        
-        if (!pubrec_received) {
-            printf("[MQTTSN] ✗ PUBREC not received (timeout)\n");
-            return -10;
-        }
-        
-        // Send PUBREL
-        unsigned char pubrel[4];
-        pubrel[0] = 4;        // Length
-        pubrel[1] = 0x10;     // PUBREL type
-        pubrel[2] = (msgid >> 8);
-        pubrel[3] = (msgid & 0xFF);
-        
-        mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, pubrel, sizeof(pubrel));
-        printf("[MQTTSN] → PUBREL sent (MsgID=%u)\n", msgid);
-        
-        // Wait for PUBCOMP (also may need to skip other messages)
-        printf("[MQTTSN] Waiting for PUBCOMP...\n");
-        bool pubcomp_received = false;
-        start_time = to_ms_since_boot(get_absolute_time());
-        
-        while (!pubcomp_received && (to_ms_since_boot(get_absolute_time()) - start_time) < 5000) {
-            int r = mqttsn_transport_receive(buf, sizeof(buf), 1000);
-            if (r > 0) {
-                uint8_t msg_type = (r >= 2) ? buf[1] : 0;
-                
-                // PUBCOMP format: [Length][0x0E][MsgId MSB][MsgId LSB]
-                if (r >= 4 && msg_type == 0x0E) {  // 0x0E = PUBCOMP
-                    unsigned short comp_msgid = (buf[2] << 8) | buf[3];
-                    printf("[MQTTSN] ✓ PUBCOMP received (MsgID=%u) - QoS 2 complete\n", comp_msgid);
-                    pubcomp_received = true;
-                } else if (msg_type == 0x18) {
-                    // Skip PINGRESP
-                    continue;
-                } else {
-                    printf("[MQTTSN] Skipping message type 0x%02X while waiting for PUBCOMP\n", msg_type);
+        } else if (r >= 4 && msg_type == 0x0F) {  // PUBREC (QoS 2 step 1)
+            unsigned short rec_msgid = (buf[2] << 8) | buf[3];
+
+            for (int i = 0; i < MQTTSN_PUBLISH_WINDOW; i++) {
+                mqttsn_inflight_t *slot = &mqttsn_inflight[i];
+                if (slot->in_use && slot->msgid == rec_msgid) {
+                    // A duplicate PUBREC (our PUBREL got lost) also lands
+                    // here and just re-sends the PUBREL
+                    slot->retries = 0;
+                    mqttsn_slot_send_pubrel(slot);
+                    break;
+                }
+            }
+        } else if (r >= 4 && msg_type == 0x0E) {  // PUBCOMP (QoS 2 complete)
+            unsigned short comp_msgid = (buf[2] << 8) | buf[3];
+
+            for (int i = 0; i < MQTTSN_PUBLISH_WINDOW; i++) {
+                mqttsn_inflight_t *slot = &mqttsn_inflight[i];
+                if (slot->in_use && slot->msgid == comp_msgid &&
+                    slot->state == MQTTSN_SLOT_WAIT_PUBCOMP) {
+                    slot->in_use = false;
+                    completed++;
+                    break;
+                }
+            }
+        } else if (msg_type == 0x0C) {  // PUBLISH - likely a NACK during transfer
+            unsigned char dup, retained;
+            unsigned short recv_msgid;
+            int qos;
+            MQTTSN_topicid topic;
+            unsigned char *payload_ptr;
+            int payloadlen_recv;
+
+            if (MQTTSNDeserialize_publish(&dup, &qos, &retained, &recv_msgid,
+                                          &topic, &payload_ptr, &payloadlen_recv,
+                                          buf, r) == 1) {
+                if (payloadlen_recv >= 1 && payload_ptr[0] == BLOCK_SACK_MAGIC) {
+                    printf("[PUBLISHER] 📩 SACK request during windowed publish!\n");
+                    block_transfer_handle_retransmit_binary(payload_ptr, payloadlen_recv);
+                } else if (payloadlen_recv >= 5 && strncmp((char*)payload_ptr, "NACK:", 5) == 0) {
+                    printf("[PUBLISHER] 📩 NACK request during windowed publish!\n");
+
+                    char request_msg[256];
+                    int copy_len = (payloadlen_recv < 255) ? payloadlen_recv : 255;
+                    memcpy(request_msg, payload_ptr, copy_len);
+                    request_msg[copy_len] = '\0';
+
+                    block_transfer_handle_retransmit_request(request_msg);
+                }
+
+                if (qos == 1) {
+                    unsigned char puback_buf[7];
+                    puback_buf[0] = 7;
+                    puback_buf[1] = 0x0D;
+                    puback_buf[2] = (topic.data.id >> 8);
+                    puback_buf[3] = (topic.data.id & 0xFF);
+                    puback_buf[4] = (recv_msgid >> 8);
+                    puback_buf[5] = (recv_msgid & 0xFF);
+                    puback_buf[6] = 0x00;
+                    mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(),
+                                          puback_buf, sizeof(puback_buf));
                 }
             }
+        } else if (msg_type == 0x16) {  // PINGREQ
+            unsigned char pingresp[] = {0x02, 0x17};
+            mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(),
+                                  pingresp, sizeof(pingresp));
         }
-        
-        if (!pubcomp_received) {
-            printf("[MQTTSN] ✗ PUBCOMP not received (timeout)\n");
-            return -11;
+    }
+
+    // Resend timed-out slots with the DUP flag set
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    for (int i = 0; i < MQTTSN_PUBLISH_WINDOW; i++) {
+        mqttsn_inflight_t *slot = &mqttsn_inflight[i];
+        if (!slot->in_use) continue;
+
+        if (now - slot->sent_ms > MQTTSN_WINDOW_ACK_TIMEOUT_MS) {
+            if (slot->retries >= MQTTSN_WINDOW_MAX_RETRIES) {
+                printf("[MQTTSN] ⚠️  MsgID=%u gave up after %d retries (NACK will recover)\n",
+                       slot->msgid, MQTTSN_WINDOW_MAX_RETRIES);
+                slot->in_use = false;
+                // An exhausted slot means the active gateway ate every
+                // retry - counts toward its failover threshold
+                mqttsn_gateway_report_failure();
+                continue;
+            }
+            slot->retries++;
+            window_resends++;
+            if (slot->state == MQTTSN_SLOT_WAIT_PUBCOMP) {
+                // PUBREL (or the PUBCOMP reply) was lost - repeat PUBREL
+                mqttsn_slot_send_pubrel(slot);
+            } else {
+                slot->pkt[2] |= 0x80;  // Set DUP flag in the PUBLISH flags byte
+                slot->sent_ms = now;
+                mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(),
+                                      slot->pkt, slot->pkt_len);
+            }
         }
-        
-        mqttsn_msg_id++;  // Increment only after complete handshake
     }
-    // For QoS 0, no acknowledgment needed, message ID stays 0
-    
-    return 0;
+
+    return completed;
+}
+
+// Wait until every in-flight PUBLISH is acknowledged (or gave up).
+// Returns the number of slots still outstanding (0 = fully drained).
+int mqttsn_publish_window_flush(uint32_t timeout_ms) {
+    uint32_t start = to_ms_since_boot(get_absolute_time());
+
+    while (mqttsn_publish_window_outstanding() > 0 &&
+           (to_ms_since_boot(get_absolute_time()) - start) < timeout_ms) {
+        mqttsn_publish_window_poll(50);
+    }
+
+    int remaining = mqttsn_publish_window_outstanding();
+    if (remaining > 0) {
+        printf("[MQTTSN] ⚠️  Window flush timeout: %d message(s) unacknowledged\n", remaining);
+        for (int i = 0; i < MQTTSN_PUBLISH_WINDOW; i++) {
+            mqttsn_inflight[i].in_use = false;
+        }
+    }
+    return remaining;
 }
 #else
 // Fallbacks when Paho isn't available
@@ -546,24 +840,56 @@ int mqttsn_demo_publish_name(const char *topicname, const uint8_t *payload, int
     (void)topicname;
     return mqttsn_demo_send_test((const char*)payload);
 }
+
+int mqttsn_publish_window_send(const char *topicname, const uint8_t *payload, int payloadlen){
+    return mqttsn_demo_publish_name(topicname, payload, payloadlen);
+}
+
+int mqttsn_publish_window_poll(uint32_t timeout_ms){
+    (void)timeout_ms;
+    return 0;
+}
+
+uint32_t mqttsn_publish_window_resends(void){
+    return 0;
+}
+
+uint32_t mqttsn_publish_window_srtt_ms(void){
+    return 0;
+}
+
+int mqttsn_publish_window_outstanding(void){
+    return 0;
+}
+
+int mqttsn_publish_window_flush(uint32_t timeout_ms){
+    (void)timeout_ms;
+    return 0;
+}
 #endif
 
 // Process a single incoming packet (blocking up to timeout_ms). If a PUBLISH
 // is received, print topic and payload. Returns number of bytes processed or
 // 0 on timeout, negative on error.
 int mqttsn_demo_process_once(uint32_t timeout_ms){
-    unsigned char buf[512];
+    unsigned char buf[MQTTSN_MAX_PACKET];
     int rc = mqttsn_transport_receive(buf, sizeof(buf), timeout_ms);
     
     if (rc > 0) {
-        printf("[UDP] Received %d bytes (blocking, %lu ms timeout)\n", rc, timeout_ms);
-        
+        LOG_TRACE("[UDP] Received %d bytes (blocking, %lu ms timeout)\n", rc, timeout_ms);
+
+        // Registered handlers get first claim on the packet; the switch
+        // below is only the default behaviour for unclaimed types
+        if (mqttsn_dispatch_packet(buf, rc) > 0) {
+            return rc;
+        }
+
         // Check message type
         if (rc >= 2) {
             uint8_t length = buf[0];
             uint8_t msg_type = buf[1];
-            
-            printf("[MQTTSN] Received message type=0x%02X, length=%d\n", msg_type, length);
+
+            LOG_TRACE("[MQTTSN] Received message type=0x%02X, length=%d\n", msg_type, length);
             
             switch (msg_type) {
                 case 0x18: // DISCONNECT
@@ -571,7 +897,7 @@ int mqttsn_demo_process_once(uint32_t timeout_ms){
                     printf("[MQTTSN] Gateway or broker closed the connection\n");
                     printf("[INFO] Check if broker is running on 127.0.0.1:1883\n");
                     mqttsn_connected = false;
-                    mqttsn_registered_topicid = 0;
+                    mqttsn_topic_registry_reset();
                     return -1;
                     
                 case 0x0C: // PUBLISH
@@ -589,20 +915,22 @@ int mqttsn_demo_process_once(uint32_t timeout_ms){
                                                                  &topic, &payload, &payloadlen, 
                                                                  buf, rc);
                         if (parse_rc == 1) {
-                            printf("[MQTTSN] Received PUBLISH: TopicID=%u, QoS=%d, MsgID=%u, PayloadLen=%d\n",
+                            LOG_TRACE("[MQTTSN] Received PUBLISH: TopicID=%u, QoS=%d, MsgID=%u, PayloadLen=%d\n",
                                    topic.data.id, qos, msgid, payloadlen);
-                            
+
                             // Print payload as text (if printable)
-                            printf("[MQTTSN] Payload: ");
-                            for (int i = 0; i < payloadlen && i < 100; i++) {
-                                if (payload[i] >= 32 && payload[i] < 127) {
-                                    printf("%c", payload[i]);
-                                } else {
-                                    printf(".");
+                            if (LOG_ENABLED(LOG_LEVEL_TRACE)) {
+                                LOG_TRACE("[MQTTSN] Payload: ");
+                                for (int i = 0; i < payloadlen && i < 100; i++) {
+                                    if (payload[i] >= 32 && payload[i] < 127) {
+                                        LOG_TRACE("%c", payload[i]);
+                                    } else {
+                                        LOG_TRACE(".");
+                                    }
                                 }
+                                if (payloadlen > 100) LOG_TRACE("...");
+                                LOG_TRACE("\n");
                             }
-                            if (payloadlen > 100) printf("...");
-                            printf("\n");
                             
                             // Send PUBACK for QoS 1
                             if (qos == 1) {
@@ -614,7 +942,7 @@ int mqttsn_demo_process_once(uint32_t timeout_ms){
                                 puback_buf[4] = (msgid >> 8);
                                 puback_buf[5] = (msgid & 0xFF);
                                 puback_buf[6] = 0x00;  // Return code (accepted)
-                                mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, 
+                                mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(), 
                                                      puback_buf, sizeof(puback_buf));
                             }
                         }
@@ -623,15 +951,20 @@ int mqttsn_demo_process_once(uint32_t timeout_ms){
                     break;
                     
                 case 0x16: // PINGREQ
-                    printf("[MQTTSN] Received PINGREQ - sending PINGRESP\n");
+                    LOG_TRACE("[MQTTSN] Received PINGREQ - sending PINGRESP\n");
                     // Send PINGRESP
                     unsigned char pingresp[] = {0x02, 0x17};
-                    mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, 
+                    mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(),
                                          pingresp, sizeof(pingresp));
                     break;
-                    
+
+                case 0x17: // PINGRESP - feeds the gateway RTT prober
+                    mqttsn_gateway_on_pingresp();
+                    break;
+
+
                 default:
-                    printf("[MQTTSN] Received non-PUBLISH or unhandled message\n");
+                    LOG_TRACE("[MQTTSN] Received non-PUBLISH or unhandled message\n");
                     break;
             }
         }
@@ -649,7 +982,7 @@ void mqttsn_demo_close(void){
             unsigned char buf[16];
             int len = MQTTSNSerialize_disconnect(buf, sizeof(buf), 0);
             if (len > 0) {
-                mqttsn_transport_send(MQTTSN_GATEWAY_IP, MQTTSN_GATEWAY_PORT, buf, len);
+                mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(), buf, len);
                 printf("[MQTTSN] DISCONNECT sent\n");
             }
 #endif
@@ -658,7 +991,7 @@ void mqttsn_demo_close(void){
         mqttsn_transport_close();
         mqttsn_initialized = false;
         mqttsn_connected = false;
-        mqttsn_registered_topicid = 0;
+        mqttsn_topic_registry_reset();
         printf("[MQTTSN] Client closed\n");
     }
 }
@@ -0,0 +1,154 @@
+// mqttsn_dispatch.c
+// Table-driven RX dispatch for MQTT-SN packets. One linear scan over a
+// small fixed table per packet; handlers receive const views into the
+// receive buffer, so the payload is never copied on its way to the
+// consumer (the block pipeline hands the same view to core 1).
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "log.h"
+#include "protocol/mqttsn/mqttsn_dispatch.h"
+#include "protocol/mqttsn/mqttsn_adapter.h"
+#include "protocol/mqttsn/mqttsn_gateway.h"
+#include "config/network_config.h"
+
+#ifdef HAVE_PAHO
+#include "MQTTSNPacket.h"
+#include "MQTTSNPublish.h"
+#endif
+
+typedef struct {
+    uint8_t msg_type;
+    uint16_t topic_id;          // Only consulted for PUBLISH
+    mqttsn_handler_t handler;
+    void *user;
+    bool in_use;
+} dispatch_entry_t;
+
+static dispatch_entry_t dispatch_table[MQTTSN_DISPATCH_HANDLERS];
+
+int mqttsn_dispatch_register(uint8_t msg_type, uint16_t topic_id,
+                             mqttsn_handler_t handler, void *user) {
+    for (int i = 0; i < MQTTSN_DISPATCH_HANDLERS; i++) {
+        if (!dispatch_table[i].in_use) {
+            dispatch_table[i].msg_type = msg_type;
+            dispatch_table[i].topic_id = topic_id;
+            dispatch_table[i].handler = handler;
+            dispatch_table[i].user = user;
+            dispatch_table[i].in_use = true;
+            return 0;
+        }
+    }
+    printf("[DISPATCH] ✗ Handler table full (type=0x%02X)\n", msg_type);
+    return -1;
+}
+
+void mqttsn_dispatch_reset(void) {
+    for (int i = 0; i < MQTTSN_DISPATCH_HANDLERS; i++) {
+        dispatch_table[i].in_use = false;
+    }
+}
+
+// Exact topic registration wins over a catch-all
+static dispatch_entry_t *dispatch_find(uint8_t msg_type, uint16_t topic_id) {
+    dispatch_entry_t *any = NULL;
+    for (int i = 0; i < MQTTSN_DISPATCH_HANDLERS; i++) {
+        if (!dispatch_table[i].in_use || dispatch_table[i].msg_type != msg_type) {
+            continue;
+        }
+        if (msg_type != 0x0C || dispatch_table[i].topic_id == topic_id) {
+            return &dispatch_table[i];
+        }
+        if (dispatch_table[i].topic_id == MQTTSN_DISPATCH_ANY_TOPIC) {
+            any = &dispatch_table[i];
+        }
+    }
+    return any;
+}
+
+#ifdef HAVE_PAHO
+// Receiver side of the QoS handshakes, centralised so every PUBLISH
+// consumer gets correct ack behaviour for free
+static void dispatch_publish_ack(uint16_t topic_id, unsigned short msgid, int qos) {
+    if (qos == 1) {
+        unsigned char puback_buf[7];
+        puback_buf[0] = 7;
+        puback_buf[1] = 0x0D;  // PUBACK
+        puback_buf[2] = (topic_id >> 8);
+        puback_buf[3] = (topic_id & 0xFF);
+        puback_buf[4] = (msgid >> 8);
+        puback_buf[5] = (msgid & 0xFF);
+        puback_buf[6] = 0x00;  // Return code (accepted)
+        mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(),
+                              puback_buf, sizeof(puback_buf));
+    } else if (qos == 2) {
+        unsigned char pubrec_buf[4];
+        pubrec_buf[0] = 4;
+        pubrec_buf[1] = 0x0F;  // PUBREC
+        pubrec_buf[2] = (msgid >> 8);
+        pubrec_buf[3] = (msgid & 0xFF);
+        mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(),
+                              pubrec_buf, sizeof(pubrec_buf));
+
+        // Wait for PUBREL, then complete with PUBCOMP
+        unsigned char pubrel_buf[16];
+        int rc = mqttsn_transport_receive(pubrel_buf, sizeof(pubrel_buf), 5000);
+        if (rc > 1 && pubrel_buf[1] == 0x10) {  // PUBREL
+            unsigned char pubcomp_buf[4];
+            pubcomp_buf[0] = 4;
+            pubcomp_buf[1] = 0x0E;  // PUBCOMP
+            pubcomp_buf[2] = (msgid >> 8);
+            pubcomp_buf[3] = (msgid & 0xFF);
+            mqttsn_transport_send(mqttsn_gateway_ip(), mqttsn_gateway_port(),
+                                  pubcomp_buf, sizeof(pubcomp_buf));
+        } else {
+            printf("[DISPATCH] ✗ PUBREL not received (MsgID=%u)\n", msgid);
+        }
+    }
+}
+#endif
+
+int mqttsn_dispatch_packet(const uint8_t *buf, int len) {
+    if (len < 2) {
+        return 0;
+    }
+    uint8_t msg_type = buf[1];
+
+    if (msg_type == 0x0C) {  // PUBLISH
+#ifdef HAVE_PAHO
+        unsigned char dup, retained;
+        unsigned short msgid;
+        int qos;
+        MQTTSN_topicid topic;
+        unsigned char *payload;
+        int payloadlen;
+
+        // The deserializer only takes offsets into buf, it does not write
+        if (MQTTSNDeserialize_publish(&dup, &qos, &retained, &msgid,
+                                      &topic, &payload, &payloadlen,
+                                      (unsigned char *)buf, len) != 1) {
+            printf("[DISPATCH] Failed to deserialize PUBLISH\n");
+            return 0;
+        }
+
+        dispatch_entry_t *entry = dispatch_find(0x0C, topic.data.id);
+        if (entry == NULL) {
+            return 0;
+        }
+        entry->handler(payload, payloadlen, topic.data.id, entry->user);
+        dispatch_publish_ack(topic.data.id, msgid, qos);
+        return 1;
+#else
+        return 0;
+#endif
+    }
+
+    dispatch_entry_t *entry = dispatch_find(msg_type, 0);
+    if (entry == NULL) {
+        return 0;
+    }
+    entry->handler(buf, len, 0, entry->user);
+    return 1;
+}
@@ -0,0 +1,203 @@
+// mqttsn_gateway.c - gateway table, RTT probing and failover
+// (see include/protocol/mqttsn/mqttsn_gateway.h)
+//
+// Probes run one at a time: a single 2-byte PINGREQ goes to the next
+// gateway in rotation, and because only one probe is ever outstanding, any
+// PINGRESP that comes back inside the window is attributable without
+// needing the datagram's source address (which the transport doesn't
+// surface). Standby gateways answer PINGREQ without a session per the
+// MQTT-SN spec, so probing them is free.
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "config/network_config.h"
+#include "protocol/mqttsn/mqttsn_adapter.h"
+#include "protocol/mqttsn/mqttsn_gateway.h"
+
+typedef struct {
+    const char *ip;
+    uint16_t port;
+    uint32_t srtt_ms;       // EWMA of probe RTT (0 = never measured)
+    uint8_t failures;       // Consecutive missed probes / ack timeouts
+    bool alive;
+} gateway_entry_t;
+
+static gateway_entry_t gateways[MQTTSN_GATEWAYS_MAX];
+static int gateway_count = 0;
+static int active = 0;
+static bool initialised = false;
+static bool changed = false;
+
+// One outstanding probe at a time
+static int probe_target = -1;
+static uint32_t probe_sent_at = 0;
+static uint32_t last_probe_ms = 0;
+static int probe_rotation = 0;
+
+void mqttsn_gateway_init(void) {
+    if (initialised) {
+        return;
+    }
+    initialised = true;
+
+    gateways[0].ip = MQTTSN_GATEWAY_IP;
+    gateways[0].port = MQTTSN_GATEWAY_PORT;
+    gateways[0].alive = true;
+    gateway_count = 1;
+
+#ifdef MQTTSN_GATEWAY2_IP
+    gateways[1].ip = MQTTSN_GATEWAY2_IP;
+    gateways[1].port = MQTTSN_GATEWAY2_PORT;
+    gateways[1].alive = true;
+    gateway_count = 2;
+#endif
+#ifdef MQTTSN_GATEWAY3_IP
+    gateways[2].ip = MQTTSN_GATEWAY3_IP;
+    gateways[2].port = MQTTSN_GATEWAY3_PORT;
+    gateways[2].alive = true;
+    gateway_count = 3;
+#endif
+
+    if (gateway_count > 1) {
+        printf("[GATEWAY] %d gateways configured, probing for health/RTT\n",
+               gateway_count);
+    }
+}
+
+const char *mqttsn_gateway_ip(void) {
+    mqttsn_gateway_init();
+    return gateways[active].ip;
+}
+
+uint16_t mqttsn_gateway_port(void) {
+    mqttsn_gateway_init();
+    return gateways[active].port;
+}
+
+// Pick the best gateway: alive with the lowest measured RTT (an unmeasured
+// alive gateway beats a dead one, nothing beats a measured healthy one)
+static int best_gateway(void) {
+    int best = -1;
+    for (int i = 0; i < gateway_count; i++) {
+        if (!gateways[i].alive) {
+            continue;
+        }
+        if (best < 0) {
+            best = i;
+            continue;
+        }
+        uint32_t best_rtt = (gateways[best].srtt_ms != 0) ? gateways[best].srtt_ms : UINT32_MAX;
+        uint32_t this_rtt = (gateways[i].srtt_ms != 0) ? gateways[i].srtt_ms : UINT32_MAX;
+        if (this_rtt < best_rtt) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+static void gateway_switch_if_needed(void) {
+    int best = best_gateway();
+    if (best < 0) {
+        // Everyone looks dead: re-arm the whole table so probing (and the
+        // app's normal reconnect path) can rediscover whichever comes back
+        for (int i = 0; i < gateway_count; i++) {
+            gateways[i].alive = true;
+            gateways[i].failures = 0;
+        }
+        return;
+    }
+    if (best != active) {
+        printf("[GATEWAY] ✗ Failover: %s:%u -> %s:%u\n",
+               gateways[active].ip, gateways[active].port,
+               gateways[best].ip, gateways[best].port);
+        active = best;
+        changed = true;
+    }
+}
+
+static void gateway_mark_failure(int idx) {
+    if (idx < 0 || idx >= gateway_count) {
+        return;
+    }
+    if (++gateways[idx].failures >= MQTTSN_GATEWAY_PROBE_FAILS) {
+        if (gateways[idx].alive) {
+            printf("[GATEWAY] ⚠️  %s:%u marked dead (%u consecutive misses)\n",
+                   gateways[idx].ip, gateways[idx].port, gateways[idx].failures);
+        }
+        gateways[idx].alive = false;
+        gateway_switch_if_needed();
+    }
+}
+
+void mqttsn_gateway_tick(void) {
+    mqttsn_gateway_init();
+    if (gateway_count < 2 && gateways[0].alive) {
+        return;  // Nothing to probe for, nothing to fail over to
+    }
+
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+
+    // Expire the outstanding probe
+    if (probe_target >= 0 &&
+        (now - probe_sent_at) > MQTTSN_GATEWAY_PROBE_TIMEOUT_MS) {
+        gateway_mark_failure(probe_target);
+        probe_target = -1;
+    }
+
+    // At most one PINGREQ per interval, rotating through the table
+    if (probe_target < 0 && (now - last_probe_ms) >= MQTTSN_GATEWAY_PROBE_MS) {
+        int idx = probe_rotation % gateway_count;
+        probe_rotation++;
+
+        const uint8_t pingreq[] = {0x02, 0x16};
+        if (mqttsn_transport_send(gateways[idx].ip, gateways[idx].port,
+                                  pingreq, sizeof(pingreq)) == 0) {
+            probe_target = idx;
+            probe_sent_at = now;
+        }
+        last_probe_ms = now;
+    }
+}
+
+void mqttsn_gateway_on_pingresp(void) {
+    if (probe_target < 0) {
+        return;  // Unsolicited (e.g. keepalive response) - nothing to attribute
+    }
+
+    uint32_t rtt = to_ms_since_boot(get_absolute_time()) - probe_sent_at;
+    gateway_entry_t *gw = &gateways[probe_target];
+
+    gw->srtt_ms = (gw->srtt_ms == 0) ? rtt : (7 * gw->srtt_ms + rtt) / 8;
+    gw->failures = 0;
+    if (!gw->alive) {
+        printf("[GATEWAY] ✓ %s:%u back alive (rtt=%lums)\n",
+               gw->ip, gw->port, (unsigned long)rtt);
+        gw->alive = true;
+    }
+    probe_target = -1;
+
+    gateway_switch_if_needed();
+}
+
+void mqttsn_gateway_report_failure(void) {
+    mqttsn_gateway_init();
+    gateway_mark_failure(active);
+}
+
+bool mqttsn_gateway_take_changed(void) {
+    bool was = changed;
+    changed = false;
+    return was;
+}
+
+void mqttsn_gateway_print_status(void) {
+    mqttsn_gateway_init();
+    for (int i = 0; i < gateway_count; i++) {
+        printf("[GATEWAY] %c %s:%u %s rtt=%lums fails=%u\n",
+               (i == active) ? '*' : ' ',
+               gateways[i].ip, gateways[i].port,
+               gateways[i].alive ? "alive" : "dead",
+               (unsigned long)gateways[i].srtt_ms, gateways[i].failures);
+    }
+}
@@ -0,0 +1,28 @@
+// crc32_host.c - software CRC-32 with the same interface and results as the
+// RP2040 DMA sniffer implementation in src/drivers/crc32.c (IEEE 802.3
+// reflected polynomial, zlib-compatible). Bitwise is plenty fast on a host.
+
+#include "drivers/crc32.h"
+
+void crc32_init(void) {
+    // No hardware to claim on the host
+}
+
+uint32_t crc32_update(uint32_t state, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++) {
+        state ^= p[i];
+        for (int bit = 0; bit < 8; bit++) {
+            state = (state >> 1) ^ (0xEDB88320u & (0u - (state & 1u)));
+        }
+    }
+    return state;
+}
+
+uint32_t crc32_finalize(uint32_t state) {
+    return state ^ 0xFFFFFFFFu;
+}
+
+uint32_t crc32_buffer(const void *data, size_t len) {
+    return crc32_finalize(crc32_update(CRC32_INIT, data, len));
+}
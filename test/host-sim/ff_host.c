@@ -0,0 +1,134 @@
+// ff_host.c - POSIX backing for the FatFs stand-in (see stubs/ff.h).
+// Every path is confined to ./sim_fs; a leading "0:" drive prefix is
+// stripped so firmware-style paths work unchanged.
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <dirent.h>
+#include <unistd.h>
+#include "ff.h"
+
+#define SIM_FS_ROOT "sim_fs"
+
+static void host_path(char *out, size_t out_len, const TCHAR *path) {
+    if (path[0] != '\0' && path[1] == ':') {
+        path += 2;  // Strip "0:" style drive prefix
+    }
+    while (*path == '/') {
+        path++;
+    }
+    snprintf(out, out_len, SIM_FS_ROOT "/%s", path);
+}
+
+void ff_host_reset(void) {
+    mkdir(SIM_FS_ROOT, 0755);
+
+    DIR *dir = opendir(SIM_FS_ROOT);
+    if (dir == NULL) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        char full[512];
+        snprintf(full, sizeof(full), SIM_FS_ROOT "/%s", entry->d_name);
+        unlink(full);
+    }
+    closedir(dir);
+}
+
+FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode) {
+    char full[512];
+    host_path(full, sizeof(full), path);
+
+    const char *fmode;
+    if (mode & FA_CREATE_ALWAYS) {
+        fmode = "w+b";
+    } else if (mode & FA_WRITE) {
+        fmode = "r+b";
+    } else {
+        fmode = "rb";
+    }
+
+    fp->fp = fopen(full, fmode);
+    fp->cltbl = NULL;
+    if (fp->fp == NULL) {
+        return FR_NO_FILE;
+    }
+
+    fseek(fp->fp, 0, SEEK_END);
+    fp->objsize = (FSIZE_t)ftell(fp->fp);
+    fseek(fp->fp, 0, SEEK_SET);
+    return FR_OK;
+}
+
+FRESULT f_close(FIL *fp) {
+    if (fp->fp == NULL) {
+        return FR_INVALID_OBJECT;
+    }
+    fclose(fp->fp);
+    fp->fp = NULL;
+    return FR_OK;
+}
+
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br) {
+    *br = (UINT)fread(buff, 1, btr, fp->fp);
+    return FR_OK;
+}
+
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw) {
+    *bw = (UINT)fwrite(buff, 1, btw, fp->fp);
+    long pos = ftell(fp->fp);
+    if (pos > 0 && (FSIZE_t)pos > fp->objsize) {
+        fp->objsize = (FSIZE_t)pos;
+    }
+    return (*bw == btw) ? FR_OK : FR_DISK_ERR;
+}
+
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs) {
+    if (ofs == CREATE_LINKMAP) {
+        return FR_OK;  // Fast-seek map is a no-op on the host
+    }
+    return (fseek(fp->fp, (long)ofs, SEEK_SET) == 0) ? FR_OK : FR_INT_ERR;
+}
+
+FRESULT f_truncate(FIL *fp) {
+    long pos = ftell(fp->fp);
+    if (pos < 0) {
+        return FR_INT_ERR;
+    }
+    fflush(fp->fp);
+    if (ftruncate(fileno(fp->fp), pos) != 0) {
+        return FR_DISK_ERR;
+    }
+    fp->objsize = (FSIZE_t)pos;
+    return FR_OK;
+}
+
+FRESULT f_expand(FIL *fp, FSIZE_t fsz, BYTE opt) {
+    // Like the real opt=1 path: allocate and make the size visible
+    (void)opt;
+    fflush(fp->fp);
+    if (ftruncate(fileno(fp->fp), (off_t)fsz) != 0) {
+        return FR_DENIED;
+    }
+    fp->objsize = fsz;
+    return FR_OK;
+}
+
+FRESULT f_unlink(const TCHAR *path) {
+    char full[512];
+    host_path(full, sizeof(full), path);
+    return (unlink(full) == 0) ? FR_OK : FR_NO_FILE;
+}
+
+FRESULT f_rename(const TCHAR *path_old, const TCHAR *path_new) {
+    char full_old[512], full_new[512];
+    host_path(full_old, sizeof(full_old), path_old);
+    host_path(full_new, sizeof(full_new), path_new);
+    return (rename(full_old, full_new) == 0) ? FR_OK : FR_NO_FILE;
+}
@@ -0,0 +1,152 @@
+// sim_link.c - lossy in-process link and the virtual clock behind the
+// pico/stdlib.h stub. The queue is delivered in deadline order, so a
+// reorder delay on one datagram really does make it arrive after its
+// successors, the same way it would on a congested Wi-Fi link.
+
+#include <stdio.h>
+#include <string.h>
+#include "sim_link.h"
+
+#define SIM_LINK_QUEUE 256
+#define SIM_TOPIC_LEN 48
+#define SIM_DATAGRAM_MAX 1600
+
+typedef struct {
+    bool used;
+    int direction;
+    uint64_t deliver_at;
+    char topic[SIM_TOPIC_LEN];
+    uint16_t len;
+    uint8_t data[SIM_DATAGRAM_MAX];
+} sim_datagram_t;
+
+static sim_link_config_t cfg;
+static sim_link_stats_t stats;
+static sim_datagram_t queue[SIM_LINK_QUEUE];
+static sim_link_deliver_t handlers[2];
+static uint64_t clock_ms = 0;
+static uint32_t rng_state = 1;
+
+// ============================================================================
+// VIRTUAL CLOCK (referenced by stubs/pico/stdlib.h)
+// ============================================================================
+
+uint64_t sim_clock_ms(void) {
+    return clock_ms;
+}
+
+void sim_clock_advance(uint32_t ms) {
+    clock_ms += ms;
+}
+
+// ============================================================================
+// PRNG (xorshift32, seeded for repeatable runs)
+// ============================================================================
+
+static uint32_t sim_rand(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static double sim_rand_unit(void) {
+    return (double)(sim_rand() & 0xFFFFFF) / (double)0x1000000;
+}
+
+// ============================================================================
+// LINK
+// ============================================================================
+
+void sim_link_init(const sim_link_config_t *config) {
+    cfg = *config;
+    memset(&stats, 0, sizeof(stats));
+    memset(queue, 0, sizeof(queue));
+    handlers[0] = NULL;
+    handlers[1] = NULL;
+    clock_ms = 0;
+    rng_state = (config->seed != 0) ? config->seed : 1;
+}
+
+void sim_link_set_handler(int direction, sim_link_deliver_t handler) {
+    handlers[direction] = handler;
+}
+
+bool sim_link_send(int direction, const char *topic, const uint8_t *data, size_t len) {
+    stats.sent[direction]++;
+    stats.bytes[direction] += len;
+
+    if (cfg.mtu != 0 && len > cfg.mtu) {
+        stats.oversize[direction]++;
+        return false;
+    }
+    if (sim_rand_unit() < cfg.loss) {
+        stats.dropped[direction]++;
+        return false;
+    }
+
+    // Serialization time is shared sender airtime: charge it to the clock
+    if (cfg.bandwidth_kbps != 0) {
+        uint32_t tx_ms = (uint32_t)((len * 8u) / cfg.bandwidth_kbps);
+        sim_clock_advance(tx_ms);
+    }
+
+    uint64_t deliver_at = clock_ms + cfg.latency_ms;
+    if (cfg.jitter_ms != 0) {
+        deliver_at += sim_rand() % (cfg.jitter_ms + 1);
+    }
+    if (sim_rand_unit() < cfg.reorder) {
+        deliver_at += cfg.latency_ms + cfg.jitter_ms + 5;  // Arrives after its successors
+    }
+
+    for (int i = 0; i < SIM_LINK_QUEUE; i++) {
+        if (!queue[i].used) {
+            queue[i].used = true;
+            queue[i].direction = direction;
+            queue[i].deliver_at = deliver_at;
+            snprintf(queue[i].topic, SIM_TOPIC_LEN, "%s", topic);
+            queue[i].len = (uint16_t)((len < SIM_DATAGRAM_MAX) ? len : SIM_DATAGRAM_MAX);
+            memcpy(queue[i].data, data, queue[i].len);
+            return true;
+        }
+    }
+
+    // Queue overflow behaves like a full RX ring: silent drop
+    stats.dropped[direction]++;
+    return false;
+}
+
+void sim_link_pump(uint32_t drain_ms) {
+    uint64_t horizon = clock_ms + drain_ms;
+
+    while (true) {
+        // Earliest due datagram at or before the horizon
+        int best = -1;
+        for (int i = 0; i < SIM_LINK_QUEUE; i++) {
+            if (queue[i].used && queue[i].deliver_at <= horizon &&
+                (best < 0 || queue[i].deliver_at < queue[best].deliver_at)) {
+                best = i;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+
+        sim_datagram_t *dg = &queue[best];
+        if (dg->deliver_at > clock_ms) {
+            clock_ms = dg->deliver_at;
+        }
+        dg->used = false;
+        if (handlers[dg->direction] != NULL) {
+            handlers[dg->direction](dg->topic, dg->data, dg->len);
+        }
+    }
+
+    if (horizon > clock_ms) {
+        clock_ms = horizon;
+    }
+}
+
+const sim_link_stats_t *sim_link_stats(void) {
+    return &stats;
+}
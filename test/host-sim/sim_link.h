@@ -0,0 +1,50 @@
+// sim_link.h - simulated UDP link between the in-process sender and receiver.
+// Datagrams are queued with a delivery time derived from configurable
+// serialization bandwidth, base latency and jitter; loss, reorder and an MTU
+// cap are applied per datagram. Delivery happens when sim_link_pump() runs
+// the virtual clock forward, invoking the callback registered per direction.
+
+#ifndef SIM_LINK_H
+#define SIM_LINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SIM_DIR_TO_RECEIVER 0   // Sender -> receiver (chunk topic)
+#define SIM_DIR_TO_SENDER   1   // Receiver -> sender (retransmit topic)
+
+typedef struct {
+    double loss;            // Per-datagram drop probability [0..1]
+    double reorder;         // Probability of an extra reorder delay
+    uint32_t latency_ms;    // Base one-way latency
+    uint32_t jitter_ms;     // Uniform extra latency [0..jitter]
+    uint32_t bandwidth_kbps;// Serialization rate (0 = infinite)
+    uint16_t mtu;           // Datagrams above this are always dropped (0 = none)
+    uint32_t seed;          // PRNG seed for repeatable runs
+} sim_link_config_t;
+
+typedef struct {
+    uint32_t sent[2];       // Datagrams offered per direction
+    uint32_t dropped[2];    // Lost to random loss
+    uint32_t oversize[2];   // Lost to the MTU cap
+    uint64_t bytes[2];      // Payload bytes offered per direction
+} sim_link_stats_t;
+
+typedef void (*sim_link_deliver_t)(const char *topic, const uint8_t *data, size_t len);
+
+void sim_link_init(const sim_link_config_t *config);
+void sim_link_set_handler(int direction, sim_link_deliver_t handler);
+
+// Queue a datagram. Returns true if it will eventually be delivered,
+// false if the link dropped it (loss or MTU) - callers that model QoS 1
+// use the return value as their "PUBACK came back" signal.
+bool sim_link_send(int direction, const char *topic, const uint8_t *data, size_t len);
+
+// Deliver every datagram due up to the current virtual time (plus drain_ms
+// of extra clock advance), calling the registered handlers in order.
+void sim_link_pump(uint32_t drain_ms);
+
+const sim_link_stats_t *sim_link_stats(void);
+
+#endif // SIM_LINK_H
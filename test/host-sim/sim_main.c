@@ -0,0 +1,249 @@
+// sim_main.c - host-side benchmark harness for the block transfer protocol.
+// Runs the real block_transfer.c sender and receiver in one process over the
+// simulated link, with configurable loss / reorder / latency / bandwidth /
+// MTU, then reports goodput and how many SACK recovery rounds completion
+// took. The virtual clock means a full transfer with seconds of simulated
+// ack timeouts finishes in milliseconds of wall time.
+//
+//   ./blocksim --loss 0.05 --latency 20 --jitter 10 --bw 500 --qos 0
+//   ./blocksim --mtu 600 --loss 0.02          # forces chunk renegotiation
+//   ./blocksim --delta --loss 0.05            # baseline send, then delta send
+//
+// Exit status is 0 only if the received file is byte-identical to the input,
+// so `make check` doubles as a regression gate for protocol changes.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include "pico/stdlib.h"
+#include "drivers/block_transfer.h"
+#include "drivers/crc32.h"
+#include "protocol/mqttsn/mqttsn_client.h"
+#include "ff.h"
+#include "sim_link.h"
+
+// From sim_mqttsn.c
+void sim_harness_init(void);
+uint32_t sim_harness_ctrl_rx(void);
+
+// From perf_host.c storage
+#include "drivers/perf_counters.h"
+
+#define SIM_CHUNK_TOPIC "pico/chunks"
+#define SIM_INPUT_FILE "image.jpg"
+#define SIM_MAX_ROUNDS 30
+
+static uint8_t input_data[MAX_SUPPORTED_FILE_SIZE];
+
+static void make_input_file(size_t size, uint32_t seed, int variant) {
+    // JPEG magic so rx_finalize picks the .jpg extension, then repetitive
+    // pseudo-random content (compressible, like real sensor images)
+    input_data[0] = 0xFF;
+    input_data[1] = 0xD8;
+    input_data[2] = 0xFF;
+    uint32_t state = seed | 1;
+    for (size_t i = 3; i < size; i++) {
+        if ((i / 64) % 3 == 0) {
+            input_data[i] = (uint8_t)(i & 0x1F);  // Flat runs LZSS can fold
+        } else {
+            state = state * 1664525u + 1013904223u;
+            input_data[i] = (uint8_t)(state >> 24);
+        }
+    }
+
+    // Delta variant: a localized edit (~2KB in the middle), like a new
+    // frame of a mostly-static scene - most chunks stay byte-identical
+    if (variant != 0 && size > 4096) {
+        for (size_t i = size / 2; i < size / 2 + 2048 && i < size; i++) {
+            input_data[i] ^= 0x5A;
+        }
+    }
+
+    FIL f;
+    UINT written;
+    if (f_open(&f, SIM_INPUT_FILE, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK ||
+        f_write(&f, input_data, (UINT)size, &written) != FR_OK || written != size) {
+        fprintf(stderr, "cannot create %s\n", SIM_INPUT_FILE);
+        exit(2);
+    }
+    f_close(&f);
+}
+
+// Latest finalized output (block_<id>.<ext>), skipping the named file so
+// the delta run is not confused with the baseline's output
+static void find_output(char *name, size_t name_len, const char *exclude) {
+    name[0] = '\0';
+    DIR *dir = opendir("sim_fs");
+    if (dir == NULL) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "block_", 6) == 0 &&
+            strcmp(entry->d_name, exclude) != 0) {
+            snprintf(name, name_len, "%s", entry->d_name);
+        }
+    }
+    closedir(dir);
+}
+
+// Compare the finalized output against the input image
+static bool verify_output(size_t size, const char *exclude) {
+    char name[300];
+    find_output(name, sizeof(name), exclude);
+    if (name[0] == '\0') {
+        printf("[SIM] ✗ No finalized output file in sim_fs/\n");
+        return false;
+    }
+
+    FIL f;
+    if (f_open(&f, name, FA_READ) != FR_OK) {
+        return false;
+    }
+    static uint8_t output_data[MAX_SUPPORTED_FILE_SIZE];
+    UINT got = 0;
+    f_read(&f, output_data, sizeof(output_data), &got);
+    f_close(&f);
+
+    if (got != size || memcmp(output_data, input_data, size) != 0) {
+        printf("[SIM] ✗ Output %s differs from input (%u vs %zu bytes, crc %08lx vs %08lx)\n",
+               name, got, size,
+               (unsigned long)crc32_buffer(output_data, got),
+               (unsigned long)crc32_buffer(input_data, size));
+        return false;
+    }
+    printf("[SIM] ✓ Output %s matches input (%zu bytes)\n", name, size);
+    return true;
+}
+
+// Drive SACK recovery the way subscriber_main does, counting the rounds.
+// Each round advances the clock past the receiver's 3s quiet gate, so one
+// loop iteration equals one real SACK/retransmit exchange.
+static int run_recovery(uint32_t round_ms) {
+    int rounds = 0;
+    sim_link_pump(round_ms);
+    while (block_transfer_get_missing_count() > 0 && rounds < SIM_MAX_ROUNDS) {
+        block_transfer_request_missing_chunks();
+        sim_link_pump(round_ms);
+        rounds++;
+    }
+    return rounds;
+}
+
+int main(int argc, char **argv) {
+    sim_link_config_t cfg = {
+        .loss = 0.0,
+        .reorder = 0.0,
+        .latency_ms = 10,
+        .jitter_ms = 0,
+        .bandwidth_kbps = 1000,
+        .mtu = 0,
+        .seed = 42,
+    };
+    size_t size = 20000;
+    int qos = 0;
+    bool delta = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) {
+            cfg.loss = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--reorder") == 0 && i + 1 < argc) {
+            cfg.reorder = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--latency") == 0 && i + 1 < argc) {
+            cfg.latency_ms = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--jitter") == 0 && i + 1 < argc) {
+            cfg.jitter_ms = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bw") == 0 && i + 1 < argc) {
+            cfg.bandwidth_kbps = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mtu") == 0 && i + 1 < argc) {
+            cfg.mtu = (uint16_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            cfg.seed = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            size = (size_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--qos") == 0 && i + 1 < argc) {
+            qos = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--delta") == 0) {
+            delta = true;
+        } else {
+            fprintf(stderr,
+                    "usage: %s [--loss p] [--reorder p] [--latency ms] [--jitter ms]\n"
+                    "          [--bw kbps] [--mtu bytes] [--seed n] [--size bytes]\n"
+                    "          [--qos 0|1|2] [--delta]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (size > MAX_SUPPORTED_FILE_SIZE) {
+        size = MAX_SUPPORTED_FILE_SIZE;
+    }
+
+    ff_host_reset();
+    sim_link_init(&cfg);
+    sim_harness_init();
+    block_transfer_init();
+
+    uint32_t round_ms = 3000 + 2 * (cfg.latency_ms + cfg.jitter_ms) + 100;
+    char baseline_name[300] = "";
+
+    if (delta) {
+        // Baseline pass (kept clean so the delta has something to reuse)
+        make_input_file(size, cfg.seed, 0);
+        if (send_image_file_qos(SIM_CHUNK_TOPIC, SIM_INPUT_FILE, (uint8_t)qos) != 0) {
+            printf("[SIM] ✗ Baseline send failed\n");
+            return 1;
+        }
+        run_recovery(round_ms);
+        if (block_transfer_get_missing_count() > 0) {
+            printf("[SIM] ✗ Baseline did not complete\n");
+            return 1;
+        }
+        find_output(baseline_name, sizeof(baseline_name), "");
+    }
+
+    make_input_file(size, cfg.seed, delta ? 1 : 0);
+
+    // Same as app_start_block_transfer: clear sender state from the
+    // previous transfer (the delta baseline survives the reset)
+    block_transfer_reset_sender();
+
+    uint64_t t0 = sim_clock_ms();
+    uint32_t chunks_before = perf.chunks_sent;
+    int rc = delta ? send_image_file_delta(SIM_CHUNK_TOPIC, SIM_INPUT_FILE, (uint8_t)qos)
+                   : send_image_file_qos(SIM_CHUNK_TOPIC, SIM_INPUT_FILE, (uint8_t)qos);
+    if (rc != 0) {
+        printf("[SIM] ✗ Send failed (rc=%d)\n", rc);
+        return 1;
+    }
+
+    int rounds = run_recovery(round_ms);
+    uint64_t elapsed = sim_clock_ms() - t0;
+    bool ok = (block_transfer_get_missing_count() == 0) &&
+              verify_output(size, baseline_name);
+
+    const sim_link_stats_t *ls = sim_link_stats();
+    printf("\n[SIM] ===== RESULT =====\n");
+    printf("[SIM] config: loss=%.3f reorder=%.3f latency=%ums jitter=%ums "
+           "bw=%ukbps mtu=%u qos=%d%s seed=%u\n",
+           cfg.loss, cfg.reorder, cfg.latency_ms, cfg.jitter_ms,
+           cfg.bandwidth_kbps, cfg.mtu, qos, delta ? " delta" : "", cfg.seed);
+    printf("[SIM] transfer: %zu bytes in %llu sim-ms -> goodput %.1f kbps\n",
+           size, (unsigned long long)elapsed,
+           (elapsed > 0) ? (double)size * 8.0 / (double)elapsed : 0.0);
+    printf("[SIM] chunks: sent=%lu (this run %lu) received=%lu retransmits=%lu "
+           "window-resends=%lu\n",
+           (unsigned long)perf.chunks_sent,
+           (unsigned long)(perf.chunks_sent - chunks_before),
+           (unsigned long)perf.chunks_received,
+           (unsigned long)perf.retransmits,
+           (unsigned long)mqttsn_publish_window_resends());
+    printf("[SIM] link: ->rx %u sent / %u lost / %u oversize, ->tx %u sent / %u lost\n",
+           ls->sent[SIM_DIR_TO_RECEIVER], ls->dropped[SIM_DIR_TO_RECEIVER],
+           ls->oversize[SIM_DIR_TO_RECEIVER],
+           ls->sent[SIM_DIR_TO_SENDER], ls->dropped[SIM_DIR_TO_SENDER]);
+    printf("[SIM] recovery: %d SACK round%s, %u control datagrams handled\n",
+           rounds, (rounds == 1) ? "" : "s", sim_harness_ctrl_rx());
+    printf("[SIM] %s\n", ok ? "✓ PASS" : "✗ FAIL");
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+// sim_mqttsn.c - MQTT-SN publish layer stand-ins for the host simulator.
+// block_transfer.c links against these instead of mqttsn_client.c: publishes
+// go over the simulated link, and the QoS 1 windowed engine is modelled as
+// attempt/ack-timeout/resend per packet, so loss shows up in the same resend
+// counter the firmware's adaptive pacing reads.
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "drivers/block_transfer.h"
+#include "protocol/mqttsn/mqttsn_client.h"
+#include "sim_link.h"
+
+// Matches the firmware's per-slot ack timeout order of magnitude
+#define SIM_ACK_TIMEOUT_MS 250
+#define SIM_QOS1_MAX_ATTEMPTS 8
+
+#define SIM_RETRANSMIT_TOPIC "pico/retransmit"
+
+static int current_qos = 0;
+static uint32_t window_resends = 0;
+static int window_unacked = 0;      // Packets the window gave up on (MTU, exhaustion)
+static uint32_t sender_ctrl_rx = 0; // SACK/NACK datagrams handled by the sender
+
+// ============================================================================
+// DELIVERY HANDLERS (wired to the link by sim_harness_init)
+// ============================================================================
+
+static void deliver_to_receiver(const char *topic, const uint8_t *data, size_t len) {
+    (void)topic;
+    process_block_chunk(data, len);
+}
+
+static void deliver_to_sender(const char *topic, const uint8_t *data, size_t len) {
+    (void)topic;
+    sender_ctrl_rx++;
+    if (len >= 1 && data[0] == BLOCK_SACK_MAGIC) {
+        block_transfer_handle_retransmit_binary(data, len);
+    } else if (len >= 5 && strncmp((const char *)data, "NACK:", 5) == 0) {
+        char request_msg[256];
+        size_t copy_len = (len < 255) ? len : 255;
+        memcpy(request_msg, data, copy_len);
+        request_msg[copy_len] = '\0';
+        block_transfer_handle_retransmit_request(request_msg);
+    }
+}
+
+void sim_harness_init(void) {
+    sim_link_set_handler(SIM_DIR_TO_RECEIVER, deliver_to_receiver);
+    sim_link_set_handler(SIM_DIR_TO_SENDER, deliver_to_sender);
+    current_qos = 0;
+    window_resends = 0;
+    window_unacked = 0;
+    sender_ctrl_rx = 0;
+}
+
+static int topic_direction(const char *topic) {
+    return (strcmp(topic, SIM_RETRANSMIT_TOPIC) == 0) ? SIM_DIR_TO_SENDER
+                                                      : SIM_DIR_TO_RECEIVER;
+}
+
+// One QoS 1 delivery: each lost attempt costs an ack timeout and a resend,
+// exactly the externally visible behaviour of the firmware window engine.
+static bool qos1_deliver(int direction, const char *topic,
+                         const uint8_t *payload, int payloadlen) {
+    for (int attempt = 0; attempt < SIM_QOS1_MAX_ATTEMPTS; attempt++) {
+        if (attempt > 0) {
+            window_resends++;
+            sim_clock_advance(SIM_ACK_TIMEOUT_MS);
+        }
+        if (sim_link_send(direction, topic, payload, (size_t)payloadlen)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// PUBLISH API (see src/protocol/mqttsn/mqttsn_client.c for the real one)
+// ============================================================================
+
+int mqttsn_demo_publish_name(const char *topicname, const uint8_t *payload, int payloadlen) {
+    int direction = topic_direction(topicname);
+    if (current_qos >= 1) {
+        return qos1_deliver(direction, topicname, payload, payloadlen) ? 0 : -1;
+    }
+    sim_link_send(direction, topicname, payload, (size_t)payloadlen);
+    return 0;  // QoS 0: fire and forget, loss is invisible to the sender
+}
+
+int mqttsn_publish_window_send(const char *topicname, const uint8_t *payload, int payloadlen) {
+    if (!qos1_deliver(topic_direction(topicname), topicname, payload, payloadlen)) {
+        window_unacked++;
+    }
+    return 0;
+}
+
+int mqttsn_publish_window_poll(uint32_t timeout_ms) {
+    sim_link_pump(timeout_ms);
+    return 0;
+}
+
+int mqttsn_publish_window_outstanding(void) {
+    return 0;  // qos1_deliver resolves each packet inline
+}
+
+int mqttsn_publish_window_flush(uint32_t timeout_ms) {
+    sim_link_pump(timeout_ms);
+    int unacked = window_unacked;
+    window_unacked = 0;
+    return unacked;
+}
+
+uint32_t mqttsn_publish_window_resends(void) {
+    return window_resends;
+}
+
+uint32_t mqttsn_publish_window_srtt_ms(void) {
+    return 2 * SIM_ACK_TIMEOUT_MS / 5;
+}
+
+int mqttsn_get_qos(void) {
+    return current_qos;
+}
+
+void mqttsn_set_qos(int qos) {
+    current_qos = qos;
+}
+
+// Sender-side drain point: the firmware reads the UDP socket here; the sim
+// just delivers whatever the receiver has already put on the wire.
+int mqttsn_check_incoming_messages(void) {
+    uint32_t before = sender_ctrl_rx;
+    sim_link_pump(0);
+    return (int)(sender_ctrl_rx - before);
+}
+
+uint32_t sim_harness_ctrl_rx(void) {
+    return sender_ctrl_rx;
+}
@@ -0,0 +1,66 @@
+// ff.h - host-sim stand-in for FatFs.
+// Maps the subset of the FatFs API the block transfer code uses onto POSIX
+// stdio inside a scratch directory (./sim_fs), so SD reads and writes become
+// ordinary host file I/O. Semantics that matter to the protocol code are
+// kept: f_expand(opt=1) sets the file size like the real one does, f_truncate
+// cuts at the current position, and CREATE_LINKMAP seeks are accepted (the
+// fast-seek map is meaningless on the host, so it is a no-op).
+
+#ifndef FF_DEFINED
+#define FF_DEFINED
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef unsigned int UINT;
+typedef uint32_t FSIZE_t;
+typedef char TCHAR;
+
+typedef enum {
+    FR_OK = 0,
+    FR_DISK_ERR,
+    FR_INT_ERR,
+    FR_NOT_READY,
+    FR_NO_FILE,
+    FR_NO_PATH,
+    FR_INVALID_NAME,
+    FR_DENIED,
+    FR_EXIST,
+    FR_INVALID_OBJECT,
+    FR_NOT_ENOUGH_CORE
+} FRESULT;
+
+#define FA_READ          0x01
+#define FA_WRITE         0x02
+#define FA_OPEN_EXISTING 0x00
+#define FA_CREATE_NEW    0x04
+#define FA_CREATE_ALWAYS 0x08
+#define FA_OPEN_ALWAYS   0x10
+
+#define CREATE_LINKMAP ((FSIZE_t)0 - 1)
+
+typedef struct {
+    FILE *fp;           // Backing host file
+    FSIZE_t objsize;    // Tracked like FatFs obj.objsize (f_size reads it)
+    DWORD *cltbl;       // Accepted and ignored (no FAT chain on the host)
+} FIL;
+
+#define f_size(fp) ((fp)->objsize)
+
+FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode);
+FRESULT f_close(FIL *fp);
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br);
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw);
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs);
+FRESULT f_truncate(FIL *fp);
+FRESULT f_expand(FIL *fp, FSIZE_t fsz, BYTE opt);
+FRESULT f_unlink(const TCHAR *path);
+FRESULT f_rename(const TCHAR *path_old, const TCHAR *path_new);
+
+// Host-sim only: scratch directory housekeeping (see ff_host.c)
+void ff_host_reset(void);
+
+#endif // FF_DEFINED
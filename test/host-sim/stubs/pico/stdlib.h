@@ -0,0 +1,38 @@
+// pico/stdlib.h - host-sim stand-in for the Pico SDK header.
+// Provides just the time primitives the protocol code touches, backed by a
+// virtual millisecond clock owned by sim_link.c. sleep_ms() advances the
+// clock instead of blocking, so a 60-second transfer simulates in an instant.
+
+#ifndef _PICO_STDLIB_H
+#define _PICO_STDLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+typedef uint64_t absolute_time_t;
+
+// Virtual clock (milliseconds since sim start), see sim_link.c
+uint64_t sim_clock_ms(void);
+void sim_clock_advance(uint32_t ms);
+
+static inline absolute_time_t get_absolute_time(void) {
+    return sim_clock_ms() * 1000u;  // Pico time is in microseconds
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000u);
+}
+
+static inline void sleep_ms(uint32_t ms) {
+    sim_clock_advance(ms);
+}
+
+static inline void sleep_us(uint64_t us) {
+    sim_clock_advance((uint32_t)(us / 1000u));
+}
+
+static inline void tight_loop_contents(void) {}
+
+#endif // _PICO_STDLIB_H